@@ -0,0 +1,148 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+namespace bench
+{
+    // Hardware event counter of the calling thread, only available on Linux with perf events enabled
+    class perf_counter
+    {
+        int fd_ = -1;
+
+    public:
+        perf_counter(std::uint32_t type, std::uint64_t config)
+        {
+#if defined(__linux__)
+            perf_event_attr attributes{};
+            attributes.size = sizeof(attributes);
+            attributes.type = type;
+            attributes.config = config;
+            attributes.disabled = 1;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+            fd_ = static_cast<int>(syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0));
+#else
+            (void)type;
+            (void)config;
+#endif
+        }
+
+        perf_counter(const perf_counter&) = delete;
+        perf_counter& operator=(const perf_counter&) = delete;
+
+        ~perf_counter()
+        {
+#if defined(__linux__)
+            if (fd_ >= 0)
+                close(fd_);
+#endif
+        }
+
+        bool available() const
+        {
+            return fd_ >= 0;
+        }
+
+        void start()
+        {
+#if defined(__linux__)
+            if (fd_ < 0)
+                return;
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+        }
+
+        long long stop()
+        {
+            long long count = -1;
+#if defined(__linux__)
+            if (fd_ < 0)
+                return count;
+            ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd_, &count, sizeof(count)) != sizeof(count))
+                count = -1;
+#endif
+            return count;
+        }
+
+        static perf_counter l1d_read_misses()
+        {
+#if defined(__linux__)
+            return perf_counter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+#else
+            return perf_counter(0, 0);
+#endif
+        }
+
+        static perf_counter last_level_misses()
+        {
+#if defined(__linux__)
+            return perf_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+#else
+            return perf_counter(0, 0);
+#endif
+        }
+    };
+
+    struct result
+    {
+        double milliseconds;    // median over all iterations
+        long long l1d_misses;   // per iteration, -1 if not available
+        long long llc_misses;   // per iteration, -1 if not available
+    };
+
+    template <typename F>
+    result measure(int iterations, F&& function)
+    {
+        auto l1d = perf_counter::l1d_read_misses();
+        auto llc = perf_counter::last_level_misses();
+
+        std::vector<double> times;
+        long long l1d_total = 0;
+        long long llc_total = 0;
+        for (int i = 0; i < iterations; i++)
+        {
+            l1d.start();
+            llc.start();
+            const auto start = std::chrono::high_resolution_clock::now();
+            function();
+            const auto stop = std::chrono::high_resolution_clock::now();
+            l1d_total += l1d.stop();
+            llc_total += llc.stop();
+            times.push_back(std::chrono::duration<double, std::milli>(stop - start).count());
+        }
+
+        std::sort(times.begin(), times.end());
+        return result{
+            times[times.size() / 2],
+            l1d.available() ? l1d_total / iterations : -1,
+            llc.available() ? llc_total / iterations : -1
+        };
+    }
+
+    inline std::string format_count(long long count)
+    {
+        return count < 0 ? std::string("n/a") : std::to_string(count);
+    }
+
+    inline void print(const std::string& name, const result& measured)
+    {
+        std::cout << std::left << std::setw(40) << name
+            << std::right << std::setw(10) << std::fixed << std::setprecision(1) << measured.milliseconds << " ms"
+            << std::setw(16) << format_count(measured.l1d_misses) << " L1D misses"
+            << std::setw(14) << format_count(measured.llc_misses) << " LLC misses" << std::endl;
+    }
+}
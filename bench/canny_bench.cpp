@@ -0,0 +1,132 @@
+#include "benchmark.h"
+#include <image/image.h>
+#include <core/core.h>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <stack>
+#include <utility>
+
+namespace
+{
+    // The stages of ApplyCanny in _old_opencv_version/ImageProcessing.cpp on array2d: every stage allocates its
+    // own full size result, the gradients are computed twice and the direction goes through atan2 and a double image
+    lib::array2d<std::uint8_t> staged_canny(const lib::array2d<std::uint8_t>& input, float low, float high)
+    {
+        auto pixels = lib::convert<float>(input);
+        auto smooth = lib::convolve(pixels, lib::make_gaussian_kernel<float>(5, 2.0));
+        auto gh = lib::convolve(smooth, lib::kernels::sobel_h<float>);
+        auto gv = lib::convolve(smooth, lib::kernels::sobel_v<float>);
+        auto magnitude = lib::sobel(smooth, lib::magnitude_mode::L2);
+
+        const auto rows = magnitude.rows();
+        const auto cols = magnitude.cols();
+        auto theta = lib::array2d<double>(rows, cols);
+        for (std::size_t i = 0; i < theta.size(); i++)
+            theta.data()[i] = std::atan2(gv.data()[i], gh.data()[i]) * 180.0 / M_PI;
+
+        auto sector = lib::array2d<std::uint8_t>(rows, cols);
+        for (std::size_t i = 0; i < sector.size(); i++)
+        {
+            const auto angle = std::fmod(theta.data()[i] + 360.0, 180.0);
+            sector.data()[i] = angle < 22.5 || angle >= 157.5 ? 0 : angle < 67.5 ? 1 : angle < 112.5 ? 2 : 3;
+        }
+
+        constexpr int row_steps[4] = { 0, 1, 1, 1 };
+        constexpr int col_steps[4] = { 1, 1, 0, -1 };
+        const auto at = [&](int row, int col) { return row < 0 || row >= rows || col < 0 || col >= cols ? 0.f : magnitude.data()[row * cols + col]; };
+        auto suppressed = lib::array2d<float>(rows, cols);
+        for (int row = 0; row < rows; row++)
+        {
+            for (int col = 0; col < cols; col++)
+            {
+                const auto s = sector.data()[row * cols + col];
+                const auto value = at(row, col);
+                const auto keep = at(row + row_steps[s], col + col_steps[s]) < value && at(row - row_steps[s], col - col_steps[s]) <= value;
+                suppressed.data()[row * cols + col] = keep ? value : 0.f;
+            }
+        }
+
+        auto output = lib::array2d<std::uint8_t>(rows, cols);
+        std::fill(output.data(), output.data() + output.size(), std::uint8_t{ 0 });
+        std::stack<std::pair<int, int>> edges;
+        for (int row = 0; row < rows; row++)
+        {
+            for (int col = 0; col < cols; col++)
+            {
+                if (suppressed.data()[row * cols + col] < high || output.data()[row * cols + col] != 0)
+                    continue;
+
+                output.data()[row * cols + col] = 255;
+                edges.push({ row, col });
+                while (!edges.empty())
+                {
+                    const auto current = edges.top();
+                    edges.pop();
+                    for (int r = current.first - 1; r <= current.first + 1; r++)
+                    {
+                        for (int c = current.second - 1; c <= current.second + 1; c++)
+                        {
+                            if (r < 0 || r >= rows || c < 0 || c >= cols)
+                                continue;
+                            if (suppressed.data()[r * cols + c] >= low && output.data()[r * cols + c] == 0)
+                            {
+                                output.data()[r * cols + c] = 255;
+                                edges.push({ r, c });
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        return output;
+    }
+
+    // Blurred random rectangles with noise, a frame with long edges and plenty of weak responses
+    lib::array2d<std::uint8_t> synthetic_frame(int rows, int cols)
+    {
+        std::mt19937 generator(11);
+        auto frame = lib::array2d<std::uint8_t>(rows, cols);
+        std::fill(frame.data(), frame.data() + static_cast<std::size_t>(rows) * cols, std::uint8_t{ 60 });
+
+        std::uniform_int_distribution<int> row_distribution(0, rows - 1);
+        std::uniform_int_distribution<int> col_distribution(0, cols - 1);
+        std::uniform_int_distribution<int> value_distribution(0, 255);
+        for (int rectangle = 0; rectangle < 200; rectangle++)
+        {
+            const auto top = row_distribution(generator);
+            const auto left = col_distribution(generator);
+            const auto bottom = std::min(rows, top + row_distribution(generator) / 4 + 1);
+            const auto right = std::min(cols, left + col_distribution(generator) / 4 + 1);
+            const auto value = static_cast<std::uint8_t>(value_distribution(generator));
+            for (int row = top; row < bottom; row++)
+                std::fill(frame.data() + static_cast<std::size_t>(row) * cols + left, frame.data() + static_cast<std::size_t>(row) * cols + right, value);
+        }
+
+        std::normal_distribution<float> noise(0.f, 6.f);
+        for (std::size_t i = 0; i < frame.size(); i++)
+            frame.data()[i] = static_cast<std::uint8_t>(std::clamp(frame.data()[i] + noise(generator), 0.f, 255.f));
+        return frame;
+    }
+}
+
+// Usage: edgedetection_canny_bench [cols rows iterations], defaults to a 1080p frame. Mirrors CannyBench of the old
+// OpenCV version, which ran ApplyCanny ten times on one image.
+int main(int argc, char** argv)
+{
+    const auto cols = argc > 2 ? std::atoi(argv[1]) : 1920;
+    const auto rows = argc > 2 ? std::atoi(argv[2]) : 1080;
+    const auto iterations = argc > 3 ? std::atoi(argv[3]) : 10;
+
+    std::cout << "Image " << cols << "x" << rows << ", " << lib::simd_level_string[static_cast<int>(lib::simd::active_level())] << std::endl;
+    const auto frame = synthetic_frame(rows, cols);
+
+    bench::print("staged (old ApplyCanny)", bench::measure(iterations, [&] { (void)staged_canny(frame, 40.f, 100.f); }));
+    bench::print("lib::canny", bench::measure(iterations, [&] { (void)lib::canny(frame, 40, 100); }));
+
+    lib::canny_workspace workspace;
+    auto edges = lib::array2d<std::uint8_t>(rows, cols);
+    bench::print("lib::canny_into, reused workspace", bench::measure(iterations, [&] { lib::canny_into(frame, edges, workspace, 40, 100); }));
+    bench::print("lib::canny_into, par", bench::measure(iterations, [&] { lib::canny_into(lib::execution::par, frame, edges, workspace, 40, 100); }));
+    return 0;
+}
@@ -0,0 +1,194 @@
+#include "benchmark.h"
+#include <image/image.h>
+#include <core/core.h>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+namespace
+{
+    template <std::size_t Height, std::size_t Width>
+    lib::kernel<Height, Width, float> random_kernel()
+    {
+        std::mt19937 generator(7);
+        std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+        auto kernel = lib::kernel<Height, Width, float>();
+        for (auto& value : kernel.values)
+            value = distribution(generator);
+        return kernel;
+    }
+
+    template <std::size_t Size>
+    lib::kernel<Size, Size, float> binomial_kernel()
+    {
+        auto factors = lib::separable_kernel<Size, Size, float>();
+        factors.row[0] = 1.f;
+        for (std::size_t n = 1; n < Size; n++)
+            for (std::size_t k = n; k > 0; k--)
+                factors.row[k] += factors.row[k - 1];
+        factors.column = factors.row;
+        return lib::make_kernel(factors);
+    }
+
+    template <std::size_t Height, std::size_t Width>
+    void compare_tiled(const std::string& name, const lib::array2d<float>& image, const lib::kernel<Height, Width, float>& kernel, int iterations)
+    {
+        bench::print(name + " row major", bench::measure(iterations, [&] { (void)lib::convolve(image, kernel); }));
+        bench::print(name + " tiled", bench::measure(iterations, [&] { (void)lib::convolve(lib::execution::tiled, image, kernel); }));
+    }
+
+    template <std::size_t Size>
+    void compare_fft(const lib::array2d<float>& image, int iterations)
+    {
+        const auto kernel = random_kernel<Size, Size>();
+        const auto name = "dense " + std::to_string(Size) + "x" + std::to_string(Size);
+        bench::print(name + " direct", bench::measure(iterations, [&]
+            {
+                auto result = lib::array2d<float>(image.rows() - static_cast<int>(Size - 1), image.cols() - static_cast<int>(Size - 1));
+                lib::internal::convolve_block(image, kernel, result.data(), result.cols(), 0, result.rows(), 0, result.cols());
+            }));
+        bench::print(name + " fft", bench::measure(iterations, [&] { (void)lib::fft_convolve(image, kernel); }));
+        std::cout << "  convolve picks " << (lib::internal::prefer_fft<float>(image.rows(), image.cols(), Size, Size) ? "fft" : "direct") << std::endl;
+    }
+}
+
+// Usage: edgedetection_convolve_bench [cols rows iterations], defaults to an 8K frame
+int main(int argc, char** argv)
+{
+    const auto cols = argc > 2 ? std::atoi(argv[1]) : 7680;
+    const auto rows = argc > 2 ? std::atoi(argv[2]) : 4320;
+    const auto iterations = argc > 3 ? std::atoi(argv[3]) : 5;
+
+    const auto& caches = lib::detect_cache_sizes();
+    std::cout << "Image " << cols << "x" << rows << ", " << lib::simd_level_string[static_cast<int>(lib::simd::active_level())]
+        << ", L1D " << caches.l1d / 1024 << " KiB, L2 " << caches.l2 / 1024 << " KiB" << std::endl;
+
+    lib::array2d<float> image(rows, cols);
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> distribution(0.f, 1.f);
+    for (auto& pixel : image)
+        pixel = distribution(generator);
+
+    compare_tiled("dense 7x7", image, random_kernel<7, 7>(), iterations);
+    compare_tiled("dense 15x15", image, random_kernel<15, 15>(), iterations);
+    compare_tiled("separable 15x15", image, binomial_kernel<15>(), iterations);
+
+    std::cout << std::endl << "Direct vs FFT crossover" << std::endl;
+    compare_fft<9>(image, iterations);
+    compare_fft<15>(image, iterations);
+    compare_fft<21>(image, iterations);
+    compare_fft<31>(image, iterations);
+    compare_fft<45>(image, iterations);
+    compare_fft<63>(image, iterations);
+
+    std::cout << std::endl << "8-bit input, 3x3 gaussian" << std::endl;
+    auto bytes = lib::array2d<std::uint8_t>(rows, cols);
+    for (std::size_t i = 0; i < bytes.size(); i++)
+        bytes.data()[i] = static_cast<std::uint8_t>(image.data()[i] * 255.f);
+    bench::print("convert to float + convolve", bench::measure(iterations, [&]
+        {
+            (void)lib::convolve(lib::convert<float>(bytes), lib::kernels::gaussian_blur<float>);
+        }));
+    bench::print("convolve_fixed int16", bench::measure(iterations, [&] { (void)lib::convolve_fixed<lib::kernels::gaussian_blur<int>, 4>(bytes); }));
+
+    std::cout << std::endl << "Color input, sobel" << std::endl;
+    auto color = lib::array2d<lib::rgb_pixel_u8>(rows, cols);
+    for (std::size_t i = 0; i < color.size(); i++)
+        color.data()[i] = lib::rgb_pixel_u8{ bytes.data()[i], static_cast<std::uint8_t>(255 - bytes.data()[i]), bytes.data()[(i * 7) % bytes.size()] };
+    bench::print("convert to float + sobel", bench::measure(iterations, [&]
+        {
+            (void)lib::sobel(lib::convert<float, lib::grayscale_mode::Luminosity>(color));
+        }));
+    bench::print("grayscale_sobel", bench::measure(iterations, [&] { (void)lib::grayscale_sobel<float>(color); }));
+
+    std::cout << std::endl << "Float sobel, magnitude modes" << std::endl;
+    bench::print("L2", bench::measure(iterations, [&] { (void)lib::sobel(image); }));
+    bench::print("L1", bench::measure(iterations, [&] { (void)lib::sobel(image, lib::magnitude_mode::L1); }));
+    bench::print("squared", bench::measure(iterations, [&] { (void)lib::sobel(image, lib::magnitude_mode::Squared); }));
+    bench::print("approximate", bench::measure(iterations, [&] { (void)lib::sobel(image, lib::magnitude_mode::Approximate); }));
+    bench::print("roberts L2", bench::measure(iterations, [&] { (void)lib::roberts(image); }));
+    bench::print("roberts L1", bench::measure(iterations, [&] { (void)lib::roberts(image, lib::magnitude_mode::L1); }));
+
+    std::cout << std::endl << "8-bit sobel with gradient components" << std::endl;
+    bench::print("sobel + convolve sobel_h, sobel_v", bench::measure(iterations, [&]
+        {
+            (void)lib::sobel(bytes);
+            const auto wide = lib::convert<int>(bytes);
+            (void)lib::convolve(wide, lib::kernels::sobel_h<int>);
+            (void)lib::convolve(wide, lib::kernels::sobel_v<int>);
+        }));
+    bench::print("sobel_planes int16", bench::measure(iterations, [&] { (void)lib::sobel_planes<std::int16_t>(bytes); }));
+    bench::print("sobel_gradients, 9 bins", bench::measure(iterations, [&] { (void)lib::sobel_gradients(bytes, 9); }));
+
+    std::cout << std::endl << "Float kirsch compass, 8 directions" << std::endl;
+    bench::print("8 convolutions + max", bench::measure(iterations, [&]
+        {
+            auto strongest = lib::convolve(image, lib::kernels::kirsch_compass<float>[0]);
+            for (std::size_t k = 1; k < 8; k++)
+            {
+                const auto response = lib::convolve(image, lib::kernels::kirsch_compass<float>[k]);
+                for (std::size_t i = 0; i < strongest.size(); i++)
+                    strongest.data()[i] = std::max(strongest.data()[i], response.data()[i]);
+            }
+        }));
+    bench::print("compass_edges", bench::measure(iterations, [&] { (void)lib::compass_edges(image, lib::kernels::kirsch_compass<float>); }));
+
+    std::cout << std::endl << "Laplacian of gaussian 15x15, sigma 2.5" << std::endl;
+    const auto factors = lib::internal::make_laplacian_factors<float>(15, 2.5, lib::laplacian_mode::Separable);
+    auto dense_log = lib::dynamic_kernel<float>{ 15, 15, std::vector<float>(15 * 15) };
+    for (std::size_t r = 0; r < 15; r++)
+    {
+        for (std::size_t c = 0; c < 15; c++)
+            dense_log.values[r * 15 + c] = factors.first_column[r] * factors.first_row[c] + factors.second_column[r] * factors.second_row[c];
+    }
+    bench::print("dense kernel (convolve)", bench::measure(iterations, [&] { (void)lib::convolve(image, dense_log); }));
+    bench::print("separable", bench::measure(iterations, [&] { (void)lib::laplacian_of_gaussian(image, 15, 2.5); }));
+    bench::print("difference of gaussians", bench::measure(iterations, [&]
+        {
+            (void)lib::laplacian_of_gaussian(image, 15, 2.5, lib::laplacian_mode::DifferenceOfGaussians);
+        }));
+
+    std::cout << std::endl << "8-bit sobel of a centered region of interest, a quarter of the frame" << std::endl;
+    const auto roi_rows = rows / 2;
+    const auto roi_cols = cols / 2;
+    bench::print("crop copy + sobel", bench::measure(iterations, [&]
+        {
+            auto crop = lib::array2d<std::uint8_t>(roi_rows, roi_cols);
+            for (int row = 0; row < roi_rows; row++)
+                std::copy_n(bytes.data() + static_cast<std::size_t>(row + rows / 4) * cols + cols / 4, roi_cols, crop.data() + static_cast<std::size_t>(row) * roi_cols);
+            (void)lib::sobel(crop);
+        }));
+    bench::print("sobel of subview", bench::measure(iterations, [&] { (void)lib::sobel(bytes.subview(rows / 4, cols / 4, roi_rows, roi_cols)); }));
+
+    // Rows of 16 KiB put the same column of every row into the same L1 set, the padding of aligned rows breaks that up
+    std::cout << std::endl << "Float 4096 pixel rows, dense vs aligned rows" << std::endl;
+    auto sensor = lib::array2d<float>(rows, 4096);
+    auto aligned_sensor = lib::array2d<float>(rows, 4096, lib::aligned_rows);
+    for (auto& pixel : sensor)
+        pixel = distribution(generator);
+    std::copy(sensor.begin(), sensor.end(), aligned_sensor.begin());
+    const auto compare_rows = [&](const std::string& name, auto&& run)
+    {
+        auto dense_output = lib::array2d<float>(rows - 2, 4096 - 2);
+        auto aligned_output = lib::array2d<float>(rows - 2, 4096 - 2, lib::aligned_rows);
+        bench::print(name + ", dense", bench::measure(iterations, [&] { run(sensor, dense_output); }));
+        bench::print(name + ", aligned", bench::measure(iterations, [&] { run(aligned_sensor, aligned_output); }));
+    };
+    compare_rows("sobel", [](const auto& input, auto& output) { lib::sobel_into(input, output); });
+    compare_rows("3x3 gaussian", [](const auto& input, auto& output) { lib::convolve_into(input, lib::kernels::gaussian_blur<float>, output); });
+    compare_rows("3x3 sharpen", [](const auto& input, auto& output) { lib::convolve_into(input, lib::kernels::sharpen<float>, output); });
+
+    // A video loop allocates the output of every stage per frame, the pool hands back the blocks of the last frame
+    std::cout << std::endl << "Float sobel with a fresh output per frame" << std::endl;
+    bench::print("new array2d", bench::measure(iterations, [&]
+        {
+            auto output = lib::array2d<float>(rows - 2, cols - 2);
+            lib::sobel_into(image, output);
+        }));
+    bench::print("pooled array2d", bench::measure(iterations, [&]
+        {
+            auto output = lib::make_pooled_array2d<float>(rows - 2, cols - 2);
+            lib::sobel_into(image, output);
+        }));
+    return 0;
+}
@@ -1,6 +1,12 @@
 #pragma once
 #include "include/array2d.h"
+#include "include/allocator.h"
+#include "include/arena.h"
 #include "include/assert.h"
+#include "include/cpu_features.h"
 #include "include/def.h"
+#include "include/execution.h"
 #include "include/log.h"
-#include "include/sliding_window_view.h"
\ No newline at end of file
+#include "include/mapped_array2d.h"
+#include "include/sliding_window_view.h"
+#include "include/thread_pool.h"
\ No newline at end of file
@@ -1,6 +1,10 @@
 #pragma once
+#include <cstddef>
 #include <cstdlib>
+#include <memory>
 #include <new>
+#include <type_traits>
+#include "array2d.h"
 
 namespace lib {
     template <typename T>
@@ -11,13 +15,13 @@ namespace lib {
 
         malloc_allocator() noexcept = default;
         template <typename U>
-        malloc_allocator(const malloc_allocator<U>&) noexcept = default;
+        malloc_allocator(const malloc_allocator<U>&) noexcept {}
 
-        T* allocate(const size_t n) const {
+        T* allocate(const std::size_t n) const {
             if (n == 0)
                 return nullptr;
 
-            void* const pt = malloc(n * sizeof(T));
+            void* const pt = std::malloc(n * sizeof(T));
 
             if (pt == nullptr)
                 throw std::bad_alloc();
@@ -25,20 +29,108 @@ namespace lib {
             return static_cast<T*>(pt);
         }
 
-        void deallocate(T * const p, const size_t n) const {
-            free(p);
+        void deallocate(T * const p, const std::size_t) const {
+            std::free(p);
         }
-    }
+    };
 
 
     template <class T, class U>
     constexpr bool operator== (const malloc_allocator<T>&, const malloc_allocator<U>&) noexcept
     {
         return true;
-    };
+    }
 
     template <class T, class U>
-    constexpr bool operator!= (const malloc_allocator<T>&, const malloc_allocator<U>&) noexcept {
-        return !(*this == other);
+    constexpr bool operator!= (const malloc_allocator<T>& lhs, const malloc_allocator<U>& rhs) noexcept {
+        return !(lhs == rhs);
+    }
+
+    namespace internal
+    {
+        // Free lists of a buffer_pool, shared with the thread caches and the deleters of its arrays, so both may outlive it
+        struct buffer_pool_state;
+
+        // Hands a block back to its pool, or frees it if the pool is gone
+        void return_block(const std::shared_ptr<buffer_pool_state>& state, void* block, std::size_t bytes) noexcept;
+    }
+
+    // Keeps freed buffers and hands them out again, so a video loop that allocates and frees the same frame sized
+    // buffers every frame stops going to the system allocator. Requests are rounded up to size classes, four per power
+    // of two, and blocks are aligned to row_alignment. Every thread keeps a few blocks per size class up to 256 KiB that
+    // it takes and returns without locking, all further and all larger blocks go to lists shared by all threads.
+    class buffer_pool
+    {
+        std::shared_ptr<internal::buffer_pool_state> state_;
+
+    public:
+        // Blocks in the shared lists beyond max_cached_bytes are freed instead of kept
+        explicit buffer_pool(std::size_t max_cached_bytes = std::size_t{ 512 } << 20);
+        buffer_pool(const buffer_pool&) = delete;
+        buffer_pool& operator=(const buffer_pool&) = delete;
+        virtual ~buffer_pool();
+
+        void* allocate(std::size_t bytes);
+
+        // bytes is the size that was passed to allocate
+        void deallocate(void* block, std::size_t bytes) noexcept;
+
+        // Frees the blocks of the shared lists and of the calling thread's cache. Other threads free the blocks they
+        // cached before on their next access to the pool, or when they exit.
+        void trim();
+
+        // Bytes held in the shared lists, excluding the thread caches
+        std::size_t cached_bytes() const;
+
+        const std::shared_ptr<internal::buffer_pool_state>& state() const;
+
+        // Process wide pool, created on first use
+        static buffer_pool& shared();
+    };
+
+    // Returns the elements of a pooled array to the pool they were taken from
+    template<typename T>
+    struct pool_deleter
+    {
+        std::shared_ptr<internal::buffer_pool_state> pool;
+        std::size_t bytes = 0;
+
+        void operator()(T* data) const noexcept
+        {
+            if (data != nullptr)
+                internal::return_block(pool, data, bytes);
+        }
+    };
+
+    template<typename T>
+    using pooled_array2d = array2d<T, pool_deleter<T>>;
+
+    namespace internal
+    {
+        template<typename T>
+        pooled_array2d<T> make_pooled_array2d(int rows, int cols, int stride, buffer_pool& pool)
+        {
+            static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>, "Pooled arrays hold trivial elements only.");
+            static_assert(row_alignment % alignof(T) == 0, "Elements must not need more than the row alignment.");
+
+            const auto bytes = static_cast<std::size_t>(rows) * stride * sizeof(T);
+            auto data = std::unique_ptr<T[], pool_deleter<T>>(static_cast<T*>(pool.allocate(bytes)), pool_deleter<T>{ pool.state(), bytes });
+            return pooled_array2d<T>(rows, cols, std::move(data), stride);
+        }
+    }
+
+    // Array whose elements are taken from the pool and returned to it on destruction. Unlike array2d(rows, cols) the
+    // elements are not initialized.
+    template<typename T>
+    pooled_array2d<T> make_pooled_array2d(int rows, int cols, buffer_pool& pool = buffer_pool::shared())
+    {
+        return internal::make_pooled_array2d<T>(rows, cols, cols, pool);
+    }
+
+    // Pooled array with rows aligned and padded like array2d(rows, cols, aligned_rows), pool blocks are aligned already
+    template<typename T>
+    pooled_array2d<T> make_pooled_array2d(int rows, int cols, aligned_rows_t, buffer_pool& pool = buffer_pool::shared())
+    {
+        return internal::make_pooled_array2d<T>(rows, cols, internal::aligned_stride<T>(cols), pool);
     }
 }
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include "allocator.h"
+#include "array2d.h"
+
+namespace lib {
+    // Bump allocator for the intermediates of a pipeline that all die together, e.g. the images between the stages of
+    // one frame. Allocations advance an offset into one reservation and are never freed one by one, reset() gives all
+    // of them back at once. Requests beyond the reservation get memory of their own, and the next reset() replaces
+    // both with one reservation large enough for everything, so from the second frame on the intermediates are
+    // contiguous. Reservations come from buffer_pool::shared(), so the arenas of repeated pipeline runs get mapped
+    // pages back instead of faulting in a fresh reservation each time. Not thread safe, allocate on one thread.
+    class arena
+    {
+        using block = std::unique_ptr<std::byte[], pool_deleter<std::byte>>;
+
+        block reservation_;
+        std::vector<block> overflow_;
+        std::size_t capacity_ = 0;
+        std::size_t used_ = 0;
+        std::size_t requested_ = 0;     // where the last allocation would end if all of them had fit the reservation
+
+        static block allocate_block(std::size_t bytes);
+
+    public:
+        explicit arena(std::size_t capacity = 0);
+        arena(arena&& other) noexcept = default;
+        arena& operator=(arena&& other) noexcept = default;
+        virtual ~arena() = default;
+
+        // bytes rounded up to alignment, which must be a power of two no larger than row_alignment
+        void* allocate(std::size_t bytes, std::size_t alignment = row_alignment);
+
+        // Invalidates everything allocated. Constant time unless allocations did not fit the reservation.
+        void reset();
+
+        // Resets and makes the reservation hold at least bytes
+        void reserve(std::size_t bytes);
+
+        std::size_t capacity() const noexcept
+        {
+            return capacity_;
+        }
+
+        // Bytes handed out since the last reset
+        std::size_t used() const noexcept
+        {
+            return requested_;
+        }
+
+        // Bytes make_array2d takes from the arena, to reserve a whole pipeline up front
+        template<typename T>
+        static constexpr std::size_t array_bytes(int rows, int cols) noexcept
+        {
+            return (static_cast<std::size_t>(rows) * cols * sizeof(T) + row_alignment - 1) / row_alignment * row_alignment;
+        }
+
+        template<typename T>
+        static std::size_t array_bytes(int rows, int cols, aligned_rows_t) noexcept
+        {
+            return array_bytes<T>(rows, internal::aligned_stride<T>(cols));
+        }
+
+        // Array whose elements live in the arena until the next reset, the view deleter leaves them to it. The
+        // elements are not initialized.
+        template<typename T>
+        array2d_view<T> make_array2d(int rows, int cols)
+        {
+            return make_array2d<T>(rows, cols, cols);
+        }
+
+        template<typename T>
+        array2d_view<T> make_array2d(int rows, int cols, aligned_rows_t)
+        {
+            return make_array2d<T>(rows, cols, internal::aligned_stride<T>(cols));
+        }
+
+    private:
+        template<typename T>
+        array2d_view<T> make_array2d(int rows, int cols, int stride)
+        {
+            static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>, "Arena arrays hold trivial elements only.");
+            static_assert(row_alignment % alignof(T) == 0, "Elements must not need more than the row alignment.");
+
+            auto* data = static_cast<T*>(allocate(array_bytes<T>(rows, stride)));
+            return make_array2d_view(data, rows, cols, stride);
+        }
+    };
+}
@@ -1,11 +1,69 @@
 #pragma once
+#include <cstdint>
 #include <vector>
 #include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 #include<iterator>
+#include <utility>
 #include "assert.h"
 
 namespace lib {
 
+    // Rows of arrays constructed with aligned_rows start on this boundary, a cache line and the widest vector register
+    inline constexpr std::size_t row_alignment = 64;
+
+    // Selects the array2d constructor with aligned and padded rows
+    struct aligned_rows_t
+    {
+    };
+
+    inline constexpr aligned_rows_t aligned_rows{};
+
+    namespace internal
+    {
+        // Rows are rounded up to whole cache lines. A row of a multiple of 4 KiB gets one more line, otherwise the same
+        // column of consecutive rows maps to the same L1 set and loads alias with the stores of the row above.
+        template<typename T>
+        int aligned_stride(int cols)
+        {
+            constexpr auto line = static_cast<int>(row_alignment / sizeof(T));
+            auto stride = (cols + line - 1) / line * line;
+            if (stride > 0 && (static_cast<std::size_t>(stride) * sizeof(T)) % 4096 == 0)
+                stride += line;
+            return stride;
+        }
+    }
+
+    // Deleter of array2d_view, which never owns its elements
+    template<typename T>
+    struct view_deleter
+    {
+        void operator()(T*) const noexcept
+        {
+        }
+    };
+
+    // Deleter of array2d_const_view, which never owns its elements and only reads them
+    template<typename T>
+    struct const_view_deleter
+    {
+        void operator()(T*) const noexcept
+        {
+        }
+    };
+
+    namespace internal
+    {
+        template<typename Deleter>
+        inline constexpr bool is_read_only_v = false;
+
+        template<typename T>
+        inline constexpr bool is_read_only_v<const_view_deleter<T>> = true;
+    }
+
+    // Walks the elements row by row and steps over the padding at the end of each row
     template<typename T>
     class array2d_iterator
     {
@@ -18,29 +76,63 @@ namespace lib {
 
     private:
         pointer ptr_;
+        difference_type col_ = 0;
+        difference_type cols_ = 0;
+        difference_type padding_ = 0;
+
+        // Moves by distance elements in row major order, the padding of every crossed row is skipped
+        void advance(difference_type distance) noexcept
+        {
+            if (padding_ == 0)
+            {
+                ptr_ += distance;
+                return;
+            }
+
+            const auto index = col_ + distance;
+            auto rows = index / cols_;
+            auto col = index % cols_;
+            if (col < 0)
+            {
+                col += cols_;
+                rows--;
+            }
+            ptr_ += rows * (cols_ + padding_) + (col - col_);
+            col_ = col;
+        }
 
     public:
         array2d_iterator() : ptr_(nullptr) {}
         array2d_iterator(pointer ptr) : ptr_(ptr) {}
+        array2d_iterator(pointer ptr, difference_type cols, difference_type stride) : ptr_(ptr), cols_(cols), padding_(stride - cols) {}
 
         array2d_iterator(array2d_iterator&& other) noexcept :
-            ptr_(std::move(other.ptr_))
+            ptr_(std::move(other.ptr_)),
+            col_(other.col_),
+            cols_(other.cols_),
+            padding_(other.padding_)
         {
             other.ptr_ = nullptr;
         }
 
-        array2d_iterator(const array2d_iterator& other) : ptr_(other.ptr_) {}
+        array2d_iterator(const array2d_iterator& other) : ptr_(other.ptr_), col_(other.col_), cols_(other.cols_), padding_(other.padding_) {}
 
 
         array2d_iterator<T>& operator=(const array2d_iterator<T>& other) noexcept
         {
             ptr_ = other.ptr_;
+            col_ = other.col_;
+            cols_ = other.cols_;
+            padding_ = other.padding_;
             return *this;
         }
 
         array2d_iterator<T>& operator=(array2d_iterator<T>&& other) noexcept
         {
             ptr_ = std::move(other.ptr_);
+            col_ = other.col_;
+            cols_ = other.cols_;
+            padding_ = other.padding_;
             other.ptr_ = nullptr;
             return *this;
         }
@@ -51,58 +143,64 @@ namespace lib {
             return *ptr_;
         }
 
-        reference operator->() const noexcept
+        pointer operator->() const noexcept
         {
             return ptr_;
         }
 
         reference operator[](difference_type distance) const noexcept
         {
-            return ptr_[distance];
+            return *(*this + distance);
         }
 
         // Increment / Decrement
         array2d_iterator& operator++() noexcept
         {
             ++ptr_;
+            if (padding_ != 0 && ++col_ == cols_)
+            {
+                ptr_ += padding_;
+                col_ = 0;
+            }
             return *this;
         }
 
         array2d_iterator operator++(int) noexcept
         {
             auto state = *this;
-            ++ptr_;
+            ++*this;
             return state;
         }
 
         array2d_iterator& operator--() noexcept
         {
-            ++ptr_;
+            advance(-1);
             return *this;
         }
 
         array2d_iterator operator--(int) noexcept
         {
             auto state = *this;
-            ++ptr_;
+            advance(-1);
             return state;
         }
 
         array2d_iterator& operator+=(difference_type distance) noexcept
         {
-            ptr_ += distance;
+            advance(distance);
             return *this;
         }
 
         array2d_iterator& operator-=(difference_type distance) noexcept
         {
-            ptr_ -= distance;
+            advance(-distance);
             return *this;
         }
 
         friend array2d_iterator operator+(array2d_iterator iterator, difference_type distance) noexcept
         {
-            return array2d_iterator(iterator.ptr_ + distance);
+            iterator.advance(distance);
+            return iterator;
         }
 
         friend array2d_iterator operator+(difference_type distance, array2d_iterator iterator) noexcept
@@ -112,12 +210,17 @@ namespace lib {
 
         friend array2d_iterator operator-(array2d_iterator iterator, difference_type distance) noexcept
         {
-            return array2d_iterator(iterator.ptr_ - distance);
+            iterator.advance(-distance);
+            return iterator;
         }
 
-        friend array2d_iterator operator-(difference_type distance, array2d_iterator iterator) noexcept
+        friend difference_type operator-(const array2d_iterator& lhs, const array2d_iterator& rhs) noexcept
         {
-            return iterator - distance;
+            if (lhs.padding_ == 0)
+                return lhs.ptr_ - rhs.ptr_;
+
+            const auto rows = ((lhs.ptr_ - lhs.col_) - (rhs.ptr_ - rhs.col_)) / (lhs.cols_ + lhs.padding_);
+            return rows * lhs.cols_ + (lhs.col_ - rhs.col_);
         }
 
         friend bool operator==(array2d_iterator lhs, array2d_iterator rhs)
@@ -153,12 +256,28 @@ namespace lib {
 
 
     template<typename T, typename Deleter = std::default_delete<T[]>>
+    class array2d;
+
+    // Non-owning rectangle of another array's elements, e.g. a region of interest of a frame. Every function taking an
+    // array2d takes a view as well, the rows of a subview keep the stride of the array they are part of.
+    template<typename T>
+    using array2d_view = array2d<T, view_deleter<T>>;
+
+    // View whose elements can only be read, what subview and view give for a const array. The element type stays
+    // non-const, so it is taken wherever an array2d is read.
+    template<typename T>
+    using array2d_const_view = array2d<T, const_view_deleter<T>>;
+
+    template<typename T, typename Deleter>
     class array2d
     {
     public:
         using value_type = T;
-        using iterator = array2d_iterator<T>;
+        using deleter_type = Deleter;
+        using element_type = std::conditional_t<internal::is_read_only_v<Deleter>, const T, T>;  // as the non-const accessors give the elements out
+        using iterator = array2d_iterator<element_type>;
         using const_iterator = array2d_iterator<const T>;
+        using view_type = std::conditional_t<internal::is_read_only_v<Deleter>, array2d_const_view<T>, array2d_view<T>>;
 
     private:
         class row
@@ -180,43 +299,77 @@ namespace lib {
                 return row_data_[col_idx];
             }
 
-            T& operator[](const int col_idx)
+            element_type& operator[](const int col_idx)
             {
                 throw_assert(col_idx < ncols_, "Array has " << ncols_ << " columns, but the requested column index was " << col_idx << ".")
                 return row_data_[col_idx];
             }
         };
 
+        template<typename View>
+        View make_subview(int row, int col, int rows, int cols) const
+        {
+            throw_assert(row >= 0 && col >= 0 && rows >= 0 && cols >= 0 && row + rows <= nrows_ && col + cols <= ncols_,
+                "Subview " << rows << "x" << cols << " at (" << row << ", " << col << ") exceeds the " << nrows_ << "x" << ncols_ << " array.")
+            using view_deleter_type = typename View::deleter_type;
+            return View(rows, cols, std::unique_ptr<T[], view_deleter_type>(origin_ + static_cast<size_t>(row) * stride_ + col), stride_);
+        }
+
         std::unique_ptr<T[], Deleter> data_;
+        T* origin_ = nullptr;   // first element, after the alignment offset of aligned arrays
         int nrows_ = 0;
         int ncols_ = 0;
+        int stride_ = 0;        // elements from one row to the next, at least ncols_
 
     public:
         array2d() : data_(nullptr), nrows_(0), ncols_(0) {}
 
-        array2d(int rows, int cols) : array2d(rows, cols, std::make_unique<T[]>(static_cast<size_t>(rows* cols)))
+        array2d(int rows, int cols) : array2d(rows, cols, std::make_unique<T[]>(static_cast<size_t>(rows) * cols))
         {
         }
 
-        array2d(int rows, int cols, std::unique_ptr<T[], Deleter>&& data) :
+        // Rows start on row_alignment bytes and are padded to stride() elements, see internal::aligned_stride
+        array2d(int rows, int cols, aligned_rows_t) : nrows_(rows), ncols_(cols), stride_(internal::aligned_stride<T>(cols))
+        {
+            static_assert(row_alignment % sizeof(T) == 0, "Elements of arrays with aligned rows must divide the row alignment.");
+            constexpr auto slack = row_alignment / sizeof(T);
+            data_ = std::make_unique<T[]>(static_cast<size_t>(rows) * stride_ + slack);
+
+            const auto address = reinterpret_cast<std::uintptr_t>(data_.get());
+            origin_ = data_.get() + (row_alignment - address % row_alignment) % row_alignment / sizeof(T);
+        }
+
+        array2d(int rows, int cols, std::unique_ptr<T[], Deleter>&& data) : array2d(rows, cols, std::move(data), cols)
+        {
+        }
+
+        // Takes over rows of stride elements each, e.g. of a pitched camera buffer, which holds at least rows * stride
+        array2d(int rows, int cols, std::unique_ptr<T[], Deleter>&& data, int stride) :
             data_(std::move(data)),
+            origin_(data_.get()),
             nrows_(rows),
-            ncols_(cols)
+            ncols_(cols),
+            stride_(stride)
         {
+            throw_assert(stride >= cols, "Stride must be at least the " << cols << " columns, but was " << stride << ".")
         }
 
         array2d(array2d<T, Deleter>&& other) noexcept :
             data_(std::move(other.data_)),
+            origin_(std::exchange(other.origin_, nullptr)),
             nrows_(std::move(other.nrows_)),
-            ncols_(std::move(other.ncols_)) 
+            ncols_(std::move(other.ncols_)),
+            stride_(std::move(other.stride_))
         {
         }
 
         array2d<T, Deleter>& operator=(array2d<T, Deleter>&& other) noexcept
         {
             data_ = std::move(other.data_);
+            origin_ = std::exchange(other.origin_, nullptr);
             nrows_ = std::move(other.nrows_);
             ncols_ = std::move(other.ncols_);
+            stride_ = std::move(other.stride_);
             return *this;
         }
 
@@ -227,7 +380,7 @@ namespace lib {
         row operator[](const int row_idx)
         {
             throw_assert(row_idx < nrows_, "Array has " << nrows_ << " rows, but the requested row index was " << row_idx << ".")
-            return row(data_.get() + static_cast<size_t>(row_idx) * ncols_, ncols_);
+            return row(origin_ + static_cast<size_t>(row_idx) * stride_, ncols_);
         }
 
         constexpr const int rows() const
@@ -240,29 +393,41 @@ namespace lib {
             return ncols_;
         }
 
+        // Elements from the start of one row to the start of the next, cols() unless the rows are padded
+        constexpr const int stride() const
+        {
+            return stride_;
+        }
+
+        constexpr const bool is_contiguous() const
+        {
+            return stride_ == ncols_;
+        }
+
+        // Computed in std::size_t, rows * cols exceeds int from 46341 x 46341 on
         constexpr const std::size_t size () const
         {
-            return ncols_ * nrows_;
+            return static_cast<std::size_t>(ncols_) * nrows_;
         }
 
         iterator begin() noexcept
         {
-            return iterator(&data_[0]);
+            return iterator(origin_, ncols_, stride_);
         }
 
         iterator end() noexcept
         {
-            return iterator(&data_[size()]);
+            return iterator(origin_ + static_cast<size_t>(nrows_) * stride_, ncols_, stride_);
         }
 
         const_iterator cbegin() const noexcept
         {
-            return const_iterator(&data_[0]);
+            return const_iterator(origin_, ncols_, stride_);
         }
 
         const_iterator cend() const noexcept
         {
-            return const_iterator(&data_[size()]);
+            return const_iterator(origin_ + static_cast<size_t>(nrows_) * stride_, ncols_, stride_);
         }
 
         const_iterator begin() const noexcept
@@ -275,20 +440,73 @@ namespace lib {
             return cend();
         }
 
-        T* data() {
-            return data_.get();
+        // The rows [row, row + rows) and columns [col, col + cols) without copying them, valid as long as this array
+        view_type subview(int row, int col, int rows, int cols)
+        {
+            return make_subview<view_type>(row, col, rows, cols);
+        }
+
+        // Views of a const array only read its elements
+        array2d_const_view<T> subview(int row, int col, int rows, int cols) const
+        {
+            return make_subview<array2d_const_view<T>>(row, col, rows, cols);
+        }
+
+        view_type view()
+        {
+            return subview(0, 0, nrows_, ncols_);
+        }
+
+        array2d_const_view<T> view() const
+        {
+            return subview(0, 0, nrows_, ncols_);
+        }
+
+        // First element of the first row, rows follow every stride() elements
+        element_type* data() {
+            return origin_;
+        }
+
+        const T* data() const {
+            return origin_;
         }
     };
 
+    // Views rows x cols elements of memory owned by someone else, e.g. a camera or decoder buffer
+    template<typename T>
+    array2d_view<T> make_array2d_view(T* data, int rows, int cols, int stride)
+    {
+        return array2d_view<T>(rows, cols, std::unique_ptr<T[], view_deleter<T>>(data), stride);
+    }
+
+    template<typename T>
+    array2d_view<T> make_array2d_view(T* data, int rows, int cols)
+    {
+        return make_array2d_view(data, rows, cols, cols);
+    }
+
+    // Read only memory gives a const view, which never writes through the pointer it holds
     template<typename T>
-    bool operator==(const array2d<T>& lhs, const array2d<T>& rhs)
+    array2d_const_view<T> make_array2d_view(const T* data, int rows, int cols, int stride)
+    {
+        return array2d_const_view<T>(rows, cols, std::unique_ptr<T[], const_view_deleter<T>>(const_cast<T*>(data)), stride);
+    }
+
+    template<typename T>
+    array2d_const_view<T> make_array2d_view(const T* data, int rows, int cols)
+    {
+        return make_array2d_view(data, rows, cols, cols);
+    }
+
+    template<typename T, typename LhsDeleter, typename RhsDeleter>
+    bool operator==(const array2d<T, LhsDeleter>& lhs, const array2d<T, RhsDeleter>& rhs)
     {
         if (lhs.rows() != rhs.rows() ||
             lhs.cols() != rhs.cols()) {
             return false;
         }
-        array2d<T>::const_iterator lhs_it;
-        array2d<T>::const_iterator rhs_it;
+        typename array2d<T, LhsDeleter>::const_iterator lhs_it;
+        typename array2d<T, RhsDeleter>::const_iterator rhs_it;
         for (lhs_it = lhs.cbegin(), rhs_it = rhs.cbegin();
             lhs_it < lhs.cend(), rhs_it < rhs.cend();
             lhs_it++, rhs_it++)
@@ -297,4 +515,17 @@ namespace lib {
         }
         return true;
     }
+
+    namespace internal
+    {
+        // Output arrays of the *_into functions are supplied by the caller and have to match the result shape exactly.
+        // Checked in every build type, a wrong shape would be written past the end of the caller's buffer.
+        template<typename T, typename Deleter>
+        void check_output_shape(const array2d<T, Deleter>& output, int rows, int cols)
+        {
+            if (output.rows() != rows || output.cols() != cols)
+                throw std::invalid_argument("Output must be " + std::to_string(rows) + "x" + std::to_string(cols) + ", but was " +
+                    std::to_string(output.rows()) + "x" + std::to_string(output.cols()) + ".");
+        }
+    }
 }
\ No newline at end of file
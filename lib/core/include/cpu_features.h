@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include "def.h"
+
+namespace lib {
+    // Instruction set levels with a vectorized implementation, ordered by capability. AVX512 needs the F and BW
+    // subsets, the kernels use 512 bit int16 arithmetic.
+    enum class simd_level : int { Scalar, SSE41, AVX2, AVX512 };
+    inline constexpr const char* const simd_level_string[] = { "Scalar", "SSE4.1", "AVX2", "AVX-512" };
+
+    struct cpu_features
+    {
+        bool sse41 = false;
+        bool avx2 = false;
+        bool fma = false;
+        bool avx512f = false;
+        bool avx512bw = false;
+    };
+
+    // Per core data cache sizes in bytes, defaults are used for levels that can not be queried
+    struct cache_sizes
+    {
+        std::size_t l1d = 32 * 1024;
+        std::size_t l2 = 256 * 1024;
+        std::size_t l3 = 8 * 1024 * 1024;
+    };
+
+    // Queried once via cpuid, including the check that the OS saves the extended register state
+    const cpu_features& detect_cpu_features();
+
+    simd_level max_simd_level();
+
+    // Read once from sysfs on Linux and GetLogicalProcessorInformation on Windows
+    const cache_sizes& detect_cache_sizes();
+}
@@ -6,4 +6,8 @@
     #define EXPORT
 #endif // WIN32
 
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    #define LIB_ARCH_X86
+#endif
+
 constexpr double M_PI = 3.14159265358979323846;
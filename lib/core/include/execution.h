@@ -0,0 +1,107 @@
+#pragma once
+#include <algorithm>
+#include <type_traits>
+#include "thread_pool.h"
+
+namespace lib::execution
+{
+    // Runs an operation on the calling thread
+    struct sequenced_policy
+    {
+    };
+
+    // Splits the output of an operation into bands of rows which are processed on a thread pool
+    struct parallel_policy
+    {
+        thread_pool* pool = nullptr;    // nullptr selects thread_pool::shared()
+        int grain = 0;                  // minimum rows per band, 0 chooses from the image size
+
+        parallel_policy on(thread_pool& executor) const
+        {
+            auto policy = *this;
+            policy.pool = &executor;
+            return policy;
+        }
+
+        parallel_policy with_grain(int rows) const
+        {
+            auto policy = *this;
+            policy.grain = rows;
+            return policy;
+        }
+    };
+
+    // Walks the output in tiles sized so the input rows of a tile stay cached while all kernel rows reuse them
+    struct tiled_policy
+    {
+        int tile_rows = 0;              // 0 chooses from the detected L2 size
+        int tile_cols = 0;              // 0 chooses from the detected L1 size
+
+        tiled_policy with_tile(int rows, int cols) const
+        {
+            auto policy = *this;
+            policy.tile_rows = rows;
+            policy.tile_cols = cols;
+            return policy;
+        }
+    };
+
+    inline constexpr sequenced_policy seq{};
+    inline constexpr parallel_policy par{};
+    inline constexpr tiled_policy tiled{};
+
+    template <typename T>
+    struct is_execution_policy : std::bool_constant<
+        std::is_same_v<std::decay_t<T>, sequenced_policy> ||
+        std::is_same_v<std::decay_t<T>, parallel_policy> ||
+        std::is_same_v<std::decay_t<T>, tiled_policy>> {};
+
+    template <typename T>
+    constexpr bool is_execution_policy_v = is_execution_policy<T>::value;
+
+    // Calls body(first_row, last_row) for bands covering [0, rows) according to the policy
+    template <typename F>
+    void for_each_row_band(const sequenced_policy&, int rows, F&& body)
+    {
+        body(0, rows);
+    }
+
+    template <typename F>
+    void for_each_row_band(const parallel_policy& policy, int rows, F&& body)
+    {
+        auto& pool = policy.pool != nullptr ? *policy.pool : thread_pool::shared();
+        // Without an explicit grain aim for about four bands per thread, but keep bands at least 16 rows high
+        const auto grain = policy.grain > 0 ? policy.grain : std::max(16, rows / static_cast<int>(4 * (pool.size() + 1)));
+        pool.parallel_for(rows, grain, body);
+    }
+
+    template <typename F>
+    void for_each_row_band(const tiled_policy& policy, int rows, F&& body)
+    {
+        const auto band = policy.tile_rows > 0 ? policy.tile_rows : rows;
+        for (int first_row = 0; first_row < rows; first_row += band)
+            body(first_row, std::min(rows, first_row + band));
+    }
+
+    // Calls body(first_row, last_row, first_col, last_col) for blocks covering a rows x cols output
+    template <typename Policy, typename F>
+    void for_each_block(const Policy& policy, int rows, int cols, F&& body)
+    {
+        for_each_row_band(policy, rows, [&](int first_row, int last_row)
+            {
+                body(first_row, last_row, 0, cols);
+            });
+    }
+
+    template <typename F>
+    void for_each_block(const tiled_policy& policy, int rows, int cols, F&& body)
+    {
+        const auto tile_rows = policy.tile_rows > 0 ? policy.tile_rows : rows;
+        const auto tile_cols = policy.tile_cols > 0 ? policy.tile_cols : cols;
+        for (int first_row = 0; first_row < rows; first_row += tile_rows)
+        {
+            for (int first_col = 0; first_col < cols; first_col += tile_cols)
+                body(first_row, std::min(rows, first_row + tile_rows), first_col, std::min(cols, first_col + tile_cols));
+        }
+    }
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include "array2d.h"
+
+namespace lib {
+    // How map_array2d maps its file
+    enum class map_mode
+    {
+        Read,       // existing file, writes stay private to the mapping and never reach the file
+        ReadWrite,  // existing file, writes go to the file
+        Create      // file created or truncated to the image size, writes go to the file
+    };
+
+    // Hints for how the OS pages the rows of a mapped array in and out
+    enum class access_pattern
+    {
+        Normal,
+        Sequential, // passes from the first row to the last, reads ahead and lets the rows behind go early
+        Random,     // no read ahead
+        WillNeed    // starts reading the rows in now
+    };
+
+    namespace internal
+    {
+        // Page aligned mappings, failures throw std::system_error
+        void* map_anonymous(std::size_t bytes);
+        void* map_file(const std::string& path, std::size_t bytes, map_mode mode);
+        void unmap(void* data, std::size_t bytes) noexcept;
+
+        // Widened to whole pages, a hint only, so failures are ignored
+        void advise(const void* data, std::size_t bytes, access_pattern pattern) noexcept;
+
+        template<typename T>
+        void check_mappable()
+        {
+            static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>, "Mapped arrays hold trivial elements only.");
+        }
+    }
+
+    // Unmaps the elements of a mapped array, bytes is the length of the mapping
+    template<typename T>
+    struct mapping_deleter
+    {
+        std::size_t bytes = 0;
+
+        void operator()(T* data) const noexcept
+        {
+            if (data != nullptr)
+                internal::unmap(data, bytes);
+        }
+    };
+
+    // Array whose rows the OS pages in on first access and may page out again, so it can exceed the memory
+    template<typename T>
+    using mapped_array2d = array2d<T, mapping_deleter<T>>;
+
+    // Applies the hint to the rows [first_row, last_row) of any array, e.g. WillNeed for the rows a sliding window
+    // reaches next
+    template<typename T, typename Deleter>
+    void advise_rows(const array2d<T, Deleter>& image, int first_row, int last_row, access_pattern pattern)
+    {
+        throw_assert(first_row >= 0 && first_row <= last_row && last_row <= image.rows(),
+            "Rows [" << first_row << ", " << last_row << ") exceed the " << image.rows() << " rows of the array.")
+        if (first_row == last_row)
+            return;
+
+        const auto* first = image.data() + static_cast<std::size_t>(first_row) * image.stride();
+        const auto elements = static_cast<std::size_t>(last_row - first_row - 1) * image.stride() + image.cols();
+        internal::advise(first, elements * sizeof(T), pattern);
+    }
+
+    // Zero initialized array on anonymous memory that reserves no swap up front (MAP_NORESERVE), pages only take
+    // memory once they are written. Untouched parts of a sparse mosaic cost nothing.
+    template<typename T>
+    mapped_array2d<T> make_mapped_array2d(int rows, int cols, access_pattern pattern = access_pattern::Sequential)
+    {
+        internal::check_mappable<T>();
+        const auto bytes = static_cast<std::size_t>(rows) * cols * sizeof(T);
+        auto data = std::unique_ptr<T[], mapping_deleter<T>>(static_cast<T*>(internal::map_anonymous(bytes)), mapping_deleter<T>{ bytes });
+        internal::advise(data.get(), bytes, pattern);
+        return mapped_array2d<T>(rows, cols, std::move(data));
+    }
+
+    // Mapped array with rows aligned and padded like array2d(rows, cols, aligned_rows), the mapping itself starts on
+    // a page
+    template<typename T>
+    mapped_array2d<T> make_mapped_array2d(int rows, int cols, aligned_rows_t, access_pattern pattern = access_pattern::Sequential)
+    {
+        internal::check_mappable<T>();
+        const auto stride = internal::aligned_stride<T>(cols);
+        const auto bytes = static_cast<std::size_t>(rows) * stride * sizeof(T);
+        auto data = std::unique_ptr<T[], mapping_deleter<T>>(static_cast<T*>(internal::map_anonymous(bytes)), mapping_deleter<T>{ bytes });
+        internal::advise(data.get(), bytes, pattern);
+        return mapped_array2d<T>(rows, cols, std::move(data), stride);
+    }
+
+    // Array on the raw rows of a file, rows * cols elements from its first byte on without any header. Read and
+    // ReadWrite need a file of at least that size.
+    template<typename T>
+    mapped_array2d<T> map_array2d(const std::string& path, int rows, int cols, map_mode mode, access_pattern pattern = access_pattern::Sequential)
+    {
+        internal::check_mappable<T>();
+        const auto bytes = static_cast<std::size_t>(rows) * cols * sizeof(T);
+        auto data = std::unique_ptr<T[], mapping_deleter<T>>(static_cast<T*>(internal::map_file(path, bytes, mode)), mapping_deleter<T>{ bytes });
+        internal::advise(data.get(), bytes, pattern);
+        return mapped_array2d<T>(rows, cols, std::move(data));
+    }
+}
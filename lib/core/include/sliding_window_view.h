@@ -2,6 +2,7 @@
 #include<type_traits>
 #include<iterator>
 #include<functional>
+#include<utility>
 
 namespace lib
 {
@@ -83,7 +84,7 @@ namespace lib
                 container_iterator iterator_;
 
             public:
-                window_row(container_iterator& iterator) : iterator_(std::move(iterator)) {}
+                window_row(container_iterator iterator) : iterator_(std::move(iterator)) {}
 
                 typename T::value_type& operator[](std::size_t col)
                 {
@@ -99,23 +100,26 @@ namespace lib
             T& container_;
             std::size_t idx_;
 
+            // idx_ counts the elements of the rows, the row address steps over the padding of strided containers
+            std::size_t offset(std::size_t row) const
+            {
+                const auto cols = static_cast<std::size_t>(container_.cols());
+                return (idx_ / cols + row) * static_cast<std::size_t>(container_.stride()) + idx_ % cols;
+            }
+
         public:
             window(T& container, const std::size_t idx) : container_(container), idx_(idx)
             {
             }
 
-            window_row<typename T::iterator> operator[](std::size_t row)
+            window_row<decltype(std::declval<T&>().data())> operator[](std::size_t row)
             {
-                auto iterator = container_.begin();
-                iterator += idx_ + row * container_.cols();
-                return window_row(std::move(iterator));
+                return window_row<decltype(std::declval<T&>().data())>(container_.data() + offset(row));
             }
 
-            const window_row<typename T::const_iterator> operator[](std::size_t row) const
+            const window_row<const value_type*> operator[](std::size_t row) const
             {
-                auto iterator = container_.cbegin();
-                iterator += idx_ + row * container_.cols();
-                return window_row(std::move(iterator));
+                return window_row<const value_type*>(container_.data() + offset(row));
             }
         };
 
@@ -0,0 +1,38 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lib {
+    class thread_pool
+    {
+        std::mutex mutex_;
+        std::condition_variable condition_;
+        std::deque<std::function<void()>> tasks_;
+        std::vector<std::thread> workers_;
+        bool stopping_ = false;
+
+        void work();
+        void enqueue(std::function<void()> task);
+
+    public:
+        // A pool of size 0 runs everything on the calling thread
+        explicit thread_pool(unsigned int threads = std::thread::hardware_concurrency());
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+        virtual ~thread_pool();
+
+        unsigned int size() const;
+
+        // Splits [0, count) into chunks of at least `grain` items and calls body(begin, end) for each of them.
+        // The calling thread works on chunks as well and returns once all chunks are done, so nested calls
+        // from inside a body can not deadlock. The first exception thrown by a body is rethrown.
+        void parallel_for(int count, int grain, const std::function<void(int, int)>& body);
+
+        // Process wide pool with one worker per hardware thread, created on first use
+        static thread_pool& shared();
+    };
+}
@@ -0,0 +1,286 @@
+#include "../include/allocator.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace lib {
+    namespace internal {
+        struct buffer_pool_state
+        {
+            std::mutex mutex;
+            std::vector<std::vector<void*>> free_blocks;
+            std::size_t max_cached_bytes = 0;
+            std::size_t cached_bytes = 0;
+            std::atomic<bool> closed{ false };
+            std::atomic<std::size_t> generation{ 0 };  // counts the trim() calls, thread caches drop blocks of older ones
+        };
+    }
+
+    namespace {
+        using internal::buffer_pool_state;
+
+        constexpr std::size_t min_block_bytes = row_alignment;
+        constexpr std::size_t thread_cache_blocks = 4;
+
+        // Larger blocks always go to the shared lists, which max_cached_bytes bounds. The thread caches hold at most
+        // thread_cache_blocks of every class below, a few MiB per thread.
+        constexpr std::size_t thread_cache_max_block_bytes = std::size_t{ 256 } << 10;
+
+        // Classes step by a quarter of a power of two from 64 bytes on: 64, 80, 96, 112, 128, 160, ...
+        std::size_t size_class(std::size_t bytes)
+        {
+            if (bytes <= min_block_bytes)
+                return 0;
+
+            const auto last = bytes - 1;
+            std::size_t octave = 0;
+            while ((last >> octave) >= 8)
+                octave++;
+
+            // (last >> octave) is in [4, 8), the class above it is the smallest one holding bytes
+            auto step = (last >> octave) - 3;
+            if (step == 4)
+            {
+                octave++;
+                step = 0;
+            }
+            return (octave - 4) * 4 + step;
+        }
+
+        std::size_t class_bytes(std::size_t size_class)
+        {
+            return (4 + size_class % 4) << (size_class / 4 + 4);
+        }
+
+        void free_block(void* block) noexcept
+        {
+            ::operator delete(block, std::align_val_t{ row_alignment });
+        }
+
+        void return_to_shared(buffer_pool_state& state, void* block, std::size_t size_class) noexcept
+        {
+            const auto bytes = class_bytes(size_class);
+            {
+                std::lock_guard<std::mutex> lock{ state.mutex };
+                if (!state.closed && state.cached_bytes + bytes <= state.max_cached_bytes)
+                {
+                    try
+                    {
+                        if (state.free_blocks.size() <= size_class)
+                            state.free_blocks.resize(size_class + 1);
+                        state.free_blocks[size_class].push_back(block);
+                        state.cached_bytes += bytes;
+                        return;
+                    }
+                    catch (...)
+                    {
+                    }
+                }
+            }
+            free_block(block);
+        }
+
+        thread_local bool cache_destroyed = false;
+
+        // The blocks a thread keeps per pool and size class, handed back to the shared lists when the thread exits
+        class thread_cache
+        {
+            struct entry
+            {
+                std::shared_ptr<buffer_pool_state> state;
+                std::size_t size_class;
+                std::size_t generation;
+                std::vector<void*> blocks;
+            };
+
+            std::vector<entry> entries_;
+
+        public:
+            ~thread_cache()
+            {
+                cache_destroyed = true;
+                for (auto& entry : entries_)
+                {
+                    drop_if_trimmed(entry);
+                    for (auto* block : entry.blocks)
+                        return_to_shared(*entry.state, block, entry.size_class);
+                }
+            }
+
+            // Frees the blocks cached before the last trim() of the pool
+            static void drop_if_trimmed(entry& cached) noexcept
+            {
+                const auto generation = cached.state->generation.load();
+                if (cached.generation == generation)
+                    return;
+
+                for (auto* block : cached.blocks)
+                    free_block(block);
+                cached.blocks.clear();
+                cached.generation = generation;
+            }
+
+            // Null if this thread holds no blocks of the class. Every access to a pool catches up with its trim() calls.
+            std::vector<void*>* find(const buffer_pool_state& state, std::size_t size_class)
+            {
+                std::vector<void*>* found = nullptr;
+                for (auto& entry : entries_)
+                {
+                    if (entry.state.get() != &state)
+                        continue;
+                    drop_if_trimmed(entry);
+                    if (entry.size_class == size_class)
+                        found = &entry.blocks;
+                }
+                return found;
+            }
+
+            std::vector<void*>& find_or_add(const std::shared_ptr<buffer_pool_state>& state, std::size_t size_class)
+            {
+                if (auto* blocks = find(*state, size_class))
+                    return *blocks;
+
+                entries_.push_back({ state, size_class, state->generation.load(), {} });
+                entries_.back().blocks.reserve(thread_cache_blocks);
+                return entries_.back().blocks;
+            }
+
+            void release(buffer_pool_state& state) noexcept
+            {
+                for (auto& entry : entries_)
+                {
+                    if (entry.state.get() != &state)
+                        continue;
+                    for (auto* block : entry.blocks)
+                        free_block(block);
+                    entry.blocks.clear();
+                }
+
+                // A closed pool gets no more blocks, so its entries only kept its state alive
+                if (state.closed)
+                    entries_.erase(std::remove_if(entries_.begin(), entries_.end(), [&](const entry& cached) { return cached.state.get() == &state; }), entries_.end());
+            }
+        };
+
+        // Null while the thread exits, blocks freed by later thread_local destructors go to the shared lists
+        thread_cache* local_cache()
+        {
+            thread_local thread_cache cache;
+            return cache_destroyed ? nullptr : &cache;
+        }
+    }
+
+    namespace internal {
+        void return_block(const std::shared_ptr<buffer_pool_state>& state, void* block, std::size_t bytes) noexcept
+        {
+            const auto index = size_class(bytes);
+            if (state->closed)
+            {
+                free_block(block);
+                return;
+            }
+
+            try
+            {
+                if (auto* cache = class_bytes(index) <= thread_cache_max_block_bytes ? local_cache() : nullptr)
+                {
+                    auto& blocks = cache->find_or_add(state, index);
+                    if (blocks.size() < thread_cache_blocks)
+                    {
+                        blocks.push_back(block);
+                        return;
+                    }
+                }
+            }
+            catch (...)
+            {
+            }
+            return_to_shared(*state, block, index);
+        }
+    }
+
+    buffer_pool::buffer_pool(std::size_t max_cached_bytes)
+        : state_(std::make_shared<internal::buffer_pool_state>())
+    {
+        state_->max_cached_bytes = max_cached_bytes;
+    }
+
+    buffer_pool::~buffer_pool()
+    {
+        // Arrays and thread caches may still hold blocks, those are freed as they come back
+        state_->closed = true;
+        trim();
+    }
+
+    void* buffer_pool::allocate(std::size_t bytes)
+    {
+        if (bytes == 0)
+            return nullptr;
+
+        const auto index = size_class(bytes);
+        if (auto* cache = class_bytes(index) <= thread_cache_max_block_bytes ? local_cache() : nullptr)
+        {
+            if (auto* blocks = cache->find(*state_, index); blocks != nullptr && !blocks->empty())
+            {
+                auto* block = blocks->back();
+                blocks->pop_back();
+                return block;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{ state_->mutex };
+            if (index < state_->free_blocks.size() && !state_->free_blocks[index].empty())
+            {
+                auto* block = state_->free_blocks[index].back();
+                state_->free_blocks[index].pop_back();
+                state_->cached_bytes -= class_bytes(index);
+                return block;
+            }
+        }
+        return ::operator new(class_bytes(index), std::align_val_t{ row_alignment });
+    }
+
+    void buffer_pool::deallocate(void* block, std::size_t bytes) noexcept
+    {
+        if (block != nullptr)
+            internal::return_block(state_, block, bytes);
+    }
+
+    void buffer_pool::trim()
+    {
+        state_->generation++;
+        if (auto* cache = local_cache())
+            cache->release(*state_);
+
+        std::vector<std::vector<void*>> blocks;
+        {
+            std::lock_guard<std::mutex> lock{ state_->mutex };
+            blocks.swap(state_->free_blocks);
+            state_->cached_bytes = 0;
+        }
+        for (const auto& list : blocks)
+        {
+            for (auto* block : list)
+                free_block(block);
+        }
+    }
+
+    std::size_t buffer_pool::cached_bytes() const
+    {
+        std::lock_guard<std::mutex> lock{ state_->mutex };
+        return state_->cached_bytes;
+    }
+
+    const std::shared_ptr<internal::buffer_pool_state>& buffer_pool::state() const
+    {
+        return state_;
+    }
+
+    buffer_pool& buffer_pool::shared()
+    {
+        static buffer_pool pool;
+        return pool;
+    }
+}
@@ -0,0 +1,62 @@
+#include "../include/arena.h"
+
+namespace lib {
+    arena::block arena::allocate_block(std::size_t bytes)
+    {
+        auto& pool = buffer_pool::shared();
+        return block(static_cast<std::byte*>(pool.allocate(bytes)), pool_deleter<std::byte>{ pool.state(), bytes });
+    }
+
+    arena::arena(std::size_t capacity)
+    {
+        reserve(capacity);
+    }
+
+    void* arena::allocate(std::size_t bytes, std::size_t alignment)
+    {
+        throw_assert(alignment > 0 && (alignment & (alignment - 1)) == 0 && alignment <= row_alignment,
+            "Alignment must be a power of two of at most " << row_alignment << ", but was " << alignment << ".")
+
+        const auto size = (bytes + alignment - 1) / alignment * alignment;
+        const auto offset = (used_ + alignment - 1) / alignment * alignment;
+        requested_ = (requested_ + alignment - 1) / alignment * alignment + size;
+        if (offset + size <= capacity_)
+        {
+            used_ = offset + size;
+            return reservation_.get() + offset;
+        }
+
+        overflow_.push_back(allocate_block(size == 0 ? alignment : size));
+        return overflow_.back().get();
+    }
+
+    void arena::reset()
+    {
+        if (!overflow_.empty())
+        {
+            // requested_ is where the last allocation would have ended in one reservation, so the next round fits
+            const auto bytes = requested_;
+            overflow_.clear();
+            reservation_.reset();
+            capacity_ = 0;
+            reservation_ = allocate_block(bytes);
+            capacity_ = bytes;
+        }
+        used_ = 0;
+        requested_ = 0;
+    }
+
+    void arena::reserve(std::size_t bytes)
+    {
+        overflow_.clear();
+        used_ = 0;
+        requested_ = 0;
+        if (bytes <= capacity_)
+            return;
+
+        reservation_.reset();
+        capacity_ = 0;
+        reservation_ = allocate_block(bytes);
+        capacity_ = bytes;
+    }
+}
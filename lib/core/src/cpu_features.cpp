@@ -0,0 +1,166 @@
+#include "../include/cpu_features.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#endif
+
+#if defined(LIB_ARCH_X86)
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #else
+        #include <cpuid.h>
+    #endif
+#endif
+
+namespace lib {
+    namespace {
+#if defined(LIB_ARCH_X86)
+        void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int (&registers)[4])
+        {
+#if defined(_MSC_VER)
+            int values[4];
+            __cpuidex(values, static_cast<int>(leaf), static_cast<int>(subleaf));
+            for (int i = 0; i < 4; i++)
+                registers[i] = static_cast<unsigned int>(values[i]);
+#else
+            __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+        }
+
+        unsigned long long xgetbv(unsigned int index)
+        {
+#if defined(_MSC_VER)
+            return _xgetbv(index);
+#else
+            unsigned int eax, edx;
+            __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
+            return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+        }
+#endif
+
+        cpu_features query_cpu_features()
+        {
+            auto features = cpu_features{};
+#if defined(LIB_ARCH_X86)
+            unsigned int registers[4] = {};
+            cpuid(0, 0, registers);
+            const auto max_leaf = registers[0];
+            if (max_leaf < 1)
+                return features;
+
+            cpuid(1, 0, registers);
+            const auto ecx = registers[2];
+            features.sse41 = (ecx & (1u << 19)) != 0;
+
+            const auto os_saves_state = (ecx & (1u << 27)) != 0;
+            const auto has_avx = (ecx & (1u << 28)) != 0;
+            if (!os_saves_state || !has_avx)
+                return features;
+
+            // XMM and YMM state (bits 1, 2) have to be enabled by the OS before AVX may be used
+            const auto xcr0 = xgetbv(0);
+            const auto ymm_enabled = (xcr0 & 0x6) == 0x6;
+            const auto zmm_enabled = (xcr0 & 0xe6) == 0xe6;
+            if (!ymm_enabled || max_leaf < 7)
+                return features;
+
+            const auto fma = (ecx & (1u << 12)) != 0;
+            cpuid(7, 0, registers);
+            const auto ebx = registers[1];
+            features.fma = fma;
+            features.avx2 = fma && (ebx & (1u << 5)) != 0;
+            features.avx512f = features.avx2 && zmm_enabled && (ebx & (1u << 16)) != 0;
+            features.avx512bw = features.avx512f && (ebx & (1u << 30)) != 0;
+#endif
+            return features;
+        }
+
+        void set_cache_size(cache_sizes& caches, int level, std::size_t size)
+        {
+            if (size == 0)
+                return;
+            if (level == 1)
+                caches.l1d = size;
+            else if (level == 2)
+                caches.l2 = size;
+            else if (level == 3)
+                caches.l3 = size;
+        }
+
+        cache_sizes query_cache_sizes()
+        {
+            auto caches = cache_sizes{};
+#if defined(_WIN32)
+            DWORD length = 0;
+            GetLogicalProcessorInformation(nullptr, &length);
+            std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> entries(length / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+            if (entries.empty() || !GetLogicalProcessorInformation(entries.data(), &length))
+                return caches;
+
+            for (const auto& entry : entries)
+            {
+                if (entry.Relationship == RelationCache && entry.Cache.Type != CacheInstruction)
+                    set_cache_size(caches, entry.Cache.Level, entry.Cache.Size);
+            }
+#elif defined(__linux__)
+            for (int index = 0; index < 16; index++)
+            {
+                const auto path = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+                std::ifstream level_file(path + "level");
+                std::ifstream type_file(path + "type");
+                std::ifstream size_file(path + "size");
+                if (!level_file || !type_file || !size_file)
+                    break;
+
+                int level = 0;
+                std::string type;
+                std::string size;
+                level_file >> level;
+                type_file >> type;
+                size_file >> size;
+                if (type == "Instruction" || size.empty())
+                    continue;
+
+                // Sizes are reported like "48K" or "30M"
+                auto bytes = static_cast<std::size_t>(std::stoull(size));
+                if (size.back() == 'K')
+                    bytes *= 1024;
+                else if (size.back() == 'M')
+                    bytes *= 1024 * 1024;
+                set_cache_size(caches, level, bytes);
+            }
+#endif
+            return caches;
+        }
+    }
+
+    const cpu_features& detect_cpu_features()
+    {
+        static const cpu_features features = query_cpu_features();
+        return features;
+    }
+
+    simd_level max_simd_level()
+    {
+        const auto& features = detect_cpu_features();
+        if (features.avx512bw)
+            return simd_level::AVX512;
+        if (features.avx2)
+            return simd_level::AVX2;
+        if (features.sse41)
+            return simd_level::SSE41;
+        return simd_level::Scalar;
+    }
+
+    const cache_sizes& detect_cache_sizes()
+    {
+        static const cache_sizes caches = query_cache_sizes();
+        return caches;
+    }
+}
@@ -0,0 +1,183 @@
+#include "../include/mapped_array2d.h"
+#include <cstdint>
+#include <system_error>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace lib {
+    namespace {
+        std::system_error file_too_small(const std::string& path, std::size_t bytes)
+        {
+            return std::system_error(std::make_error_code(std::errc::invalid_argument),
+                "File " + path + " holds fewer than the " + std::to_string(bytes) + " bytes of the image");
+        }
+
+#if defined(_WIN32)
+        std::system_error last_error(const std::string& what)
+        {
+            return std::system_error(static_cast<int>(GetLastError()), std::system_category(), what);
+        }
+
+        struct handle_closer
+        {
+            HANDLE handle;
+
+            ~handle_closer()
+            {
+                if (handle != nullptr && handle != INVALID_HANDLE_VALUE)
+                    CloseHandle(handle);
+            }
+        };
+
+        // The view keeps the mapping alive, so the handles close right away and UnmapViewOfFile frees everything
+        void* map_view(HANDLE file, std::size_t bytes, DWORD protection, DWORD access, const std::string& what)
+        {
+            const auto size = static_cast<std::uint64_t>(bytes);
+            const auto mapping = handle_closer{ CreateFileMappingW(file, nullptr, protection, static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), nullptr) };
+            if (mapping.handle == nullptr)
+                throw last_error(what);
+
+            auto* data = MapViewOfFile(mapping.handle, access, 0, 0, bytes);
+            if (data == nullptr)
+                throw last_error(what);
+            return data;
+        }
+#else
+        std::system_error last_error(const std::string& what)
+        {
+            return std::system_error(errno, std::generic_category(), what);
+        }
+
+        struct file_closer
+        {
+            int descriptor;
+
+            ~file_closer()
+            {
+                if (descriptor >= 0)
+                    close(descriptor);
+            }
+        };
+
+        void* map(int descriptor, std::size_t bytes, int flags, const std::string& what)
+        {
+            auto* data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, flags, descriptor, 0);
+            if (data == MAP_FAILED)
+                throw last_error(what);
+            return data;
+        }
+#endif
+    }
+
+    namespace internal {
+        void* map_anonymous(std::size_t bytes)
+        {
+            if (bytes == 0)
+                return nullptr;
+
+#if defined(_WIN32)
+            // Backed by the page file, Windows charges the commit up front but pages still take memory only when written
+            return map_view(INVALID_HANDLE_VALUE, bytes, PAGE_READWRITE, FILE_MAP_WRITE, "Could not map " + std::to_string(bytes) + " bytes");
+#else
+            return map(-1, bytes, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, "Could not map " + std::to_string(bytes) + " bytes");
+#endif
+        }
+
+        void* map_file(const std::string& path, std::size_t bytes, map_mode mode)
+        {
+            const auto what = "Could not map " + path;
+#if defined(_WIN32)
+            const auto access = mode == map_mode::Read ? GENERIC_READ : GENERIC_READ | GENERIC_WRITE;
+            const auto disposition = mode == map_mode::Create ? CREATE_ALWAYS : OPEN_EXISTING;
+            const auto file = handle_closer{ CreateFileA(path.c_str(), access, FILE_SHARE_READ, nullptr, disposition, FILE_ATTRIBUTE_NORMAL, nullptr) };
+            if (file.handle == INVALID_HANDLE_VALUE)
+                throw last_error(what);
+
+            if (mode != map_mode::Create)
+            {
+                LARGE_INTEGER size;
+                if (!GetFileSizeEx(file.handle, &size))
+                    throw last_error(what);
+                if (static_cast<std::uint64_t>(size.QuadPart) < bytes)
+                    throw file_too_small(path, bytes);
+            }
+            if (bytes == 0)
+                return nullptr;
+
+            // A created file grows to the size of the mapping
+            if (mode == map_mode::Read)
+                return map_view(file.handle, bytes, PAGE_WRITECOPY, FILE_MAP_COPY, what);
+            return map_view(file.handle, bytes, PAGE_READWRITE, FILE_MAP_WRITE, what);
+#else
+            const auto flags = mode == map_mode::Read ? O_RDONLY : mode == map_mode::ReadWrite ? O_RDWR : O_RDWR | O_CREAT | O_TRUNC;
+            const auto file = file_closer{ open(path.c_str(), flags, 0644) };
+            if (file.descriptor < 0)
+                throw last_error(what);
+
+            if (mode == map_mode::Create)
+            {
+                // Sparse, the file system allocates blocks only for the rows that get written
+                if (ftruncate(file.descriptor, static_cast<off_t>(bytes)) != 0)
+                    throw last_error(what);
+            }
+            else
+            {
+                struct stat status;
+                if (fstat(file.descriptor, &status) != 0)
+                    throw last_error(what);
+                if (static_cast<std::size_t>(status.st_size) < bytes)
+                    throw file_too_small(path, bytes);
+            }
+            if (bytes == 0)
+                return nullptr;
+
+            // Private pages of a read mapping are copied on write and need no swap reserved for that either
+            if (mode == map_mode::Read)
+                return map(file.descriptor, bytes, MAP_PRIVATE | MAP_NORESERVE, what);
+            return map(file.descriptor, bytes, MAP_SHARED, what);
+#endif
+        }
+
+        void unmap(void* data, std::size_t bytes) noexcept
+        {
+#if defined(_WIN32)
+            (void)bytes;
+            UnmapViewOfFile(data);
+#else
+            munmap(data, bytes);
+#endif
+        }
+
+        void advise(const void* data, std::size_t bytes, access_pattern pattern) noexcept
+        {
+            if (data == nullptr || bytes == 0)
+                return;
+
+#if defined(_WIN32)
+            // Windows has no equivalent of these hints, its read ahead follows the faults on its own
+            (void)pattern;
+#else
+            static const auto page = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+            const auto address = reinterpret_cast<std::uintptr_t>(data);
+            const auto first = address / page * page;
+            const auto last = (address + bytes + page - 1) / page * page;
+
+            const auto advice = pattern == access_pattern::Sequential ? MADV_SEQUENTIAL
+                : pattern == access_pattern::Random ? MADV_RANDOM
+                : pattern == access_pattern::WillNeed ? MADV_WILLNEED
+                : MADV_NORMAL;
+            madvise(reinterpret_cast<void*>(first), last - first, advice);
+#endif
+        }
+    }
+}
@@ -0,0 +1,137 @@
+#include "../include/thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+namespace lib {
+    namespace {
+        // Shared between the caller and the helper tasks, which may start after parallel_for returned
+        struct parallel_for_state
+        {
+            std::function<void(int, int)> body;
+            int count;
+            int chunk_size;
+            int chunks;
+            std::atomic<int> next_chunk{ 0 };
+            std::atomic<int> finished_chunks{ 0 };
+            std::mutex mutex;
+            std::condition_variable done;
+            std::exception_ptr exception;
+
+            void run_chunks()
+            {
+                for (auto chunk = next_chunk++; chunk < chunks; chunk = next_chunk++)
+                {
+                    const auto begin = chunk * chunk_size;
+                    const auto end = std::min(count, begin + chunk_size);
+                    try
+                    {
+                        body(begin, end);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock{ mutex };
+                        if (!exception)
+                            exception = std::current_exception();
+                    }
+
+                    if (++finished_chunks == chunks)
+                    {
+                        std::lock_guard<std::mutex> lock{ mutex };
+                        done.notify_all();
+                    }
+                }
+            }
+        };
+    }
+
+    thread_pool::thread_pool(unsigned int threads)
+    {
+        workers_.reserve(threads);
+        for (unsigned int i = 0; i < threads; i++)
+            workers_.emplace_back([this] { work(); });
+    }
+
+    thread_pool::~thread_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+            stopping_ = true;
+        }
+        condition_.notify_all();
+        for (auto& worker : workers_)
+            worker.join();
+    }
+
+    unsigned int thread_pool::size() const
+    {
+        return static_cast<unsigned int>(workers_.size());
+    }
+
+    void thread_pool::work()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock{ mutex_ };
+                condition_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+                if (tasks_.empty())
+                    return;
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    void thread_pool::enqueue(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+            tasks_.push_back(std::move(task));
+        }
+        condition_.notify_one();
+    }
+
+    void thread_pool::parallel_for(int count, int grain, const std::function<void(int, int)>& body)
+    {
+        if (count <= 0)
+            return;
+
+        grain = std::max(grain, 1);
+        const auto max_chunks = (count + grain - 1) / grain;
+        if (max_chunks == 1 || workers_.empty())
+        {
+            body(0, count);
+            return;
+        }
+
+        // A few chunks per thread balance uneven chunk costs without too much scheduling overhead
+        const auto chunks = std::min(max_chunks, static_cast<int>(workers_.size() + 1) * 4);
+
+        auto state = std::make_shared<parallel_for_state>();
+        state->body = body;
+        state->count = count;
+        state->chunk_size = (count + chunks - 1) / chunks;
+        state->chunks = (count + state->chunk_size - 1) / state->chunk_size;
+
+        const auto helpers = std::min(static_cast<int>(workers_.size()), state->chunks - 1);
+        for (int i = 0; i < helpers; i++)
+            enqueue([state] { state->run_chunks(); });
+
+        state->run_chunks();
+
+        std::unique_lock<std::mutex> lock{ state->mutex };
+        state->done.wait(lock, [&state] { return state->finished_chunks == state->chunks; });
+        if (state->exception)
+            std::rethrow_exception(state->exception);
+    }
+
+    thread_pool& thread_pool::shared()
+    {
+        static thread_pool pool;
+        return pool;
+    }
+}
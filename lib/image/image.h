@@ -3,7 +3,14 @@
 #include "include/image_writer.h"
 #include "include/pixel.h"
 #include "include/dft.h"
+#include "include/fft_convolve.h"
+#include "include/fixed_convolve.h"
 #include "include/image_converter.h"
 #include "include/convolve.h"
 #include "include/kernel.h"
-#include "include/edge_detection.h"
\ No newline at end of file
+#include "include/edge_detection.h"
+#include "include/canny.h"
+#include "include/laplacian.h"
+#include "include/simd.h"
+#include "include/border.h"
+#include "include/magnitude.h"
\ No newline at end of file
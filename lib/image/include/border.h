@@ -0,0 +1,97 @@
+#pragma once
+#include <core/core.h>
+#include <type_traits>
+
+// Border policies of the full size convolve and sobel overloads. They describe which value is read
+// for a pixel outside the image, shown for the row abcd:
+namespace lib::border
+{
+    // vvv|abcd|vvv
+    struct constant
+    {
+        double value = 0;
+    };
+
+    // aaa|abcd|ddd
+    struct replicate
+    {
+        static constexpr int map(int index, int size)
+        {
+            return index < 0 ? 0 : (index >= size ? size - 1 : index);
+        }
+    };
+
+    // dcb|abcd|cba, the edge pixel itself is not repeated
+    struct reflect
+    {
+        static constexpr int map(int index, int size)
+        {
+            if (size == 1)
+                return 0;
+
+            const auto period = 2 * (size - 1);
+            index %= period;
+            if (index < 0)
+                index += period;
+            return index < size ? index : period - index;
+        }
+    };
+
+    // bcd|abcd|abc
+    struct wrap
+    {
+        static constexpr int map(int index, int size)
+        {
+            index %= size;
+            return index < 0 ? index + size : index;
+        }
+    };
+
+    template <typename T>
+    struct is_border : std::bool_constant<
+        std::is_same_v<std::decay_t<T>, constant> ||
+        std::is_same_v<std::decay_t<T>, replicate> ||
+        std::is_same_v<std::decay_t<T>, reflect> ||
+        std::is_same_v<std::decay_t<T>, wrap>> {};
+
+    template <typename T>
+    constexpr bool is_border_v = is_border<T>::value;
+}
+
+namespace lib::internal
+{
+    // Reads input(row, col) for any row and col, the pixels outside the image are resolved by the border policy
+    template <typename T, typename Border>
+    T border_sample(const T* input, std::ptrdiff_t stride, int rows, int cols, int row, int col, const Border& border)
+    {
+        if constexpr (std::is_same_v<Border, border::constant>)
+        {
+            if (row < 0 || row >= rows || col < 0 || col >= cols)
+                return static_cast<T>(border.value);
+            return input[row * stride + col];
+        }
+        else
+        {
+            return input[Border::map(row, rows) * stride + Border::map(col, cols)];
+        }
+    }
+
+    // Calls body(row, first_col, last_col) for every span of the rows [first_row, last_row) outside the interior
+    // [top, bottom) x [left, right), so a full size pass only has to deal with borders in a handful of pixels
+    template <typename F>
+    void for_each_border_span(int first_row, int last_row, int cols, int top, int bottom, int left, int right, F&& body)
+    {
+        for (int row = first_row; row < last_row; row++)
+        {
+            if (row < top || row >= bottom || left >= right)
+            {
+                body(row, 0, cols);
+            }
+            else
+            {
+                body(row, 0, left);
+                body(row, right, cols);
+            }
+        }
+    }
+}
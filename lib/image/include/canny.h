@@ -0,0 +1,414 @@
+#pragma once
+#include <core/core.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "convolve.h"
+#include "kernel.h"
+#include "magnitude.h"
+#include "pixel.h"
+
+namespace lib
+{
+    // Intermediate images of canny. A workspace kept by the caller makes repeated calls on images of the same size
+    // allocation free. The images and the hysteresis labels are carved from one arena reservation, all of them again
+    // whenever the size changes.
+    struct canny_workspace
+    {
+        arena memory;
+        array2d_view<float> pixels;
+        array2d_view<float> smoothed;
+        array2d_view<float> magnitude;
+        array2d_view<std::uint8_t> sectors;
+        array2d_view<std::ptrdiff_t> labels;    // indexed like the edge map, row * stride + col
+        array2d_view<std::uint8_t> strong;
+        std::vector<std::uint8_t> band_starts;
+        std::vector<std::ptrdiff_t> merged;
+        dynamic_kernel<float> gaussian;
+        double sigma = 0;                       // of the gaussian, once it is built
+    };
+
+    namespace internal
+    {
+        // Pixel states of the edge map between non maximum suppression and hysteresis
+        constexpr std::uint8_t canny_none = 0;
+        constexpr std::uint8_t canny_weak = 1;
+        constexpr std::uint8_t canny_edge = 255;
+
+        // Rows and columns the 5x5 gaussian and the 3x3 sobel cut off on every side
+        constexpr int canny_margin = 3;
+
+        template<typename T>
+        bool has_shape(const array2d_view<T>& image, int rows, int cols)
+        {
+            return image.rows() == rows && image.cols() == cols;
+        }
+
+        // Sizes the workspace for an input of rows x cols and an edge map with output_stride, pixels only holds the
+        // float copy of inputs of another type
+        template<typename T>
+        void prepare_canny_workspace(canny_workspace& workspace, int input_rows, int input_cols, int output_stride)
+        {
+            constexpr auto convert = !std::is_same_v<T, float>;
+            const auto pixel_rows = convert ? input_rows : 0;
+            const auto pixel_cols = convert ? input_cols : 0;
+            const auto rows = input_rows - 2 * canny_margin;
+            const auto cols = input_cols - 2 * canny_margin;
+            if (has_shape(workspace.pixels, pixel_rows, pixel_cols) && has_shape(workspace.smoothed, rows + 2, cols + 2) &&
+                has_shape(workspace.magnitude, rows, cols) && has_shape(workspace.labels, input_rows, output_stride))
+                return;
+
+            auto& memory = workspace.memory;
+            memory.reserve(arena::array_bytes<float>(pixel_rows, pixel_cols) + arena::array_bytes<float>(rows + 2, cols + 2) +
+                arena::array_bytes<float>(rows, cols) + arena::array_bytes<std::uint8_t>(rows, cols) +
+                arena::array_bytes<std::ptrdiff_t>(input_rows, output_stride) + arena::array_bytes<std::uint8_t>(input_rows, output_stride));
+            workspace.pixels = memory.make_array2d<float>(pixel_rows, pixel_cols);
+            workspace.smoothed = memory.make_array2d<float>(rows + 2, cols + 2);
+            workspace.magnitude = memory.make_array2d<float>(rows, cols);
+            workspace.sectors = memory.make_array2d<std::uint8_t>(rows, cols);
+            workspace.labels = memory.make_array2d<std::ptrdiff_t>(input_rows, output_stride);
+            workspace.strong = memory.make_array2d<std::uint8_t>(input_rows, output_stride);
+        }
+
+        // Casts every pixel to float, row by row so the padding of strided images is skipped
+        template<typename T, typename Deleter>
+        void convert_pixels(const array2d<T, Deleter>& input, array2d_view<float>& pixels)
+        {
+            for (int row = 0; row < input.rows(); row++)
+            {
+                const auto* source = input.data() + static_cast<std::size_t>(row) * input.stride();
+                std::transform(source, source + input.cols(), pixels.data() + static_cast<std::size_t>(row) * pixels.stride(),
+                    [](const T& pixel) { return static_cast<float>(pixel); });
+            }
+        }
+
+        // Quantizes the gradient direction: 0 horizontal, 1 down right, 2 vertical, 3 down left. The sector boundaries
+        // at 22.5 and 67.5 degrees are compared through tan(22.5) on the absolute gradients instead of an atan2, the sign
+        // of gx * gy then picks the diagonal. Free of branches, so the gradient loop vectorizes.
+        inline std::uint8_t gradient_sector(float gx, float gy)
+        {
+            constexpr auto tan_22_5 = 0.41421356f;
+            const auto ax = std::abs(gx);
+            const auto ay = std::abs(gy);
+            const auto horizontal = ay <= ax * tan_22_5;
+            const auto vertical = ax < ay * tan_22_5;
+            const auto diagonal = (gx < 0.f) == (gy < 0.f) ? 1 : 3;
+            return static_cast<std::uint8_t>(horizontal ? 0 : vertical ? 2 : diagonal);
+        }
+
+        // Gradient magnitude and direction sector of the rows [first_row, last_row), both sobel directions come from
+        // one pass over the smoothed image
+        inline void canny_gradients(const array2d_view<float>& smoothed, array2d_view<float>& magnitude, array2d_view<std::uint8_t>& sectors, int first_row, int last_row)
+        {
+            const auto stride = static_cast<std::ptrdiff_t>(smoothed.cols());
+            const auto cols = magnitude.cols();
+            for (int row = first_row; row < last_row; row++)
+            {
+                const auto* top = smoothed.data() + row * stride;
+                const auto* middle = top + stride;
+                const auto* bottom = middle + stride;
+                auto* magnitude_row = magnitude.data() + static_cast<std::size_t>(row) * cols;
+                auto* sector_row = sectors.data() + static_cast<std::size_t>(row) * cols;
+                for (int col = 0; col < cols; col++)
+                {
+                    const auto gx = (top[col] - top[col + 2]) + 2.f * (middle[col] - middle[col + 2]) + (bottom[col] - bottom[col + 2]);
+                    const auto gy = (top[col] - bottom[col]) + 2.f * (top[col + 1] - bottom[col + 1]) + (top[col + 2] - bottom[col + 2]);
+                    magnitude_row[col] = combine_gradients<magnitude_mode::L2>(gx, gy);
+                    sector_row[col] = gradient_sector(gx, gy);
+                }
+            }
+        }
+
+        // Keeps the pixels that are a maximum across the edge, emit(value, keep) turns each pixel into its output, so
+        // canny classifies by the thresholds in the same pass. A pixel is suppressed if the neighbour ahead is at least
+        // as large or the one behind is larger, so a plateau keeps exactly one pixel. Neighbours outside the magnitude
+        // image count as 0, the inner columns of inner rows skip that check.
+        template<typename TOut, typename F>
+        void suppress_non_maxima(const array2d_view<float>& magnitude, const array2d_view<std::uint8_t>& sectors,
+            TOut* output, std::ptrdiff_t output_stride, int first_row, int last_row, F&& emit)
+        {
+            constexpr int row_steps[4] = { 0, 1, 1, 1 };
+            constexpr int col_steps[4] = { 1, 1, 0, -1 };
+            const auto rows = magnitude.rows();
+            const auto cols = magnitude.cols();
+            const auto* values = magnitude.data();
+            const auto at = [&](int row, int col)
+            {
+                return row < 0 || row >= rows || col < 0 || col >= cols ? 0.f : values[static_cast<std::size_t>(row) * cols + col];
+            };
+            const std::ptrdiff_t offsets[4] = { 1, cols + 1, cols, cols - 1 };
+
+            for (int row = first_row; row < last_row; row++)
+            {
+                const auto* value_row = values + static_cast<std::size_t>(row) * cols;
+                const auto* sector_row = sectors.data() + static_cast<std::size_t>(row) * cols;
+                auto* output_row = output + row * output_stride;
+                const auto inner = row > 0 && row < rows - 1;
+                for (int col = 0; col < cols; col++)
+                {
+                    const auto sector = sector_row[col];
+                    if (inner && col > 0 && col < cols - 1)
+                    {
+                        const auto value = value_row[col];
+                        const auto offset = offsets[sector];
+                        output_row[col] = emit(value, value > value_row[col + offset] && value >= value_row[col - offset]);
+                    }
+                    else
+                    {
+                        const auto value = value_row[col];
+                        const auto ahead = at(row + row_steps[sector], col + col_steps[sector]);
+                        const auto behind = at(row - row_steps[sector], col - col_steps[sector]);
+                        output_row[col] = emit(value, value > ahead && value >= behind);
+                    }
+                }
+            }
+        }
+
+        inline void canny_suppress(const array2d_view<float>& magnitude, const array2d_view<std::uint8_t>& sectors, float low, float high,
+            std::uint8_t* output, std::ptrdiff_t output_stride, int first_row, int last_row)
+        {
+            suppress_non_maxima(magnitude, sectors, output, output_stride, first_row, last_row, [=](float value, bool keep)
+                {
+                    return !keep || value < low ? canny_none : value >= high ? canny_edge : canny_weak;
+                });
+        }
+
+        // Union-find over pixel indices, the smaller index always becomes the root and the root carries the strong flag.
+        // Indices are 64 bit, edge maps may hold more than 2^31 pixels.
+        inline std::ptrdiff_t find_label(std::ptrdiff_t* labels, std::ptrdiff_t index)
+        {
+            while (labels[index] != index)
+            {
+                labels[index] = labels[labels[index]];
+                index = labels[index];
+            }
+            return index;
+        }
+
+        // Returns the root that stopped being one, or -1 if both were already connected
+        inline std::ptrdiff_t unite_labels(std::ptrdiff_t* labels, std::uint8_t* strong, std::ptrdiff_t a, std::ptrdiff_t b)
+        {
+            auto root_a = find_label(labels, a);
+            auto root_b = find_label(labels, b);
+            if (root_a == root_b)
+                return -1;
+            if (root_a > root_b)
+                std::swap(root_a, root_b);
+
+            labels[root_b] = root_a;
+            strong[root_a] |= strong[root_b];
+            return root_b;
+        }
+
+        // Promotes every weak pixel that is 8-connected to an edge pixel and clears the remaining ones. Every band of
+        // rows labels its candidates on its own, touching only its own entries of the label array, then the seams
+        // between the bands are merged on the calling thread and a last parallel pass resolves each pixel's component.
+        // Labels are indexed like the pixels, row * stride + col, so the padding of strided edge maps is never labeled.
+        template<typename ExecutionPolicy, typename Deleter>
+        void canny_hysteresis(const ExecutionPolicy& policy, array2d<std::uint8_t, Deleter>& edges, canny_workspace& workspace)
+        {
+            const auto rows = edges.rows();
+            const auto cols = edges.cols();
+            const auto stride = static_cast<std::ptrdiff_t>(edges.stride());
+            auto* states = edges.data();
+            // Sized by canny_into already, unless the edge map comes from elsewhere
+            if (!has_shape(workspace.labels, rows, edges.stride()))
+                prepare_canny_workspace<float>(workspace, rows, cols, edges.stride());
+            auto* labels = workspace.labels.data();
+            auto* strong = workspace.strong.data();
+            workspace.band_starts.assign(static_cast<std::size_t>(rows), 0);
+
+            execution::for_each_row_band(policy, rows, [&](int first_row, int last_row)
+                {
+                    workspace.band_starts[first_row] = 1;
+                    for (int row = first_row; row < last_row; row++)
+                    {
+                        for (int col = 0; col < cols; col++)
+                        {
+                            const auto index = row * stride + col;
+                            if (states[index] == canny_none)
+                                continue;
+
+                            labels[index] = index;
+                            strong[index] = states[index] == canny_edge;
+                            if (col > 0 && states[index - 1] != canny_none)
+                                unite_labels(labels, strong, index, index - 1);
+                            if (row == first_row)
+                                continue;
+                            for (int c = std::max(0, col - 1); c <= std::min(cols - 1, col + 1); c++)
+                            {
+                                if (states[index - stride - col + c] != canny_none)
+                                    unite_labels(labels, strong, index, index - stride - col + c);
+                            }
+                        }
+                    }
+
+                    for (int row = first_row; row < last_row; row++)
+                    {
+                        for (auto index = row * stride; index < row * stride + cols; index++)
+                        {
+                            if (states[index] != canny_none)
+                                labels[index] = find_label(labels, index);
+                        }
+                    }
+                });
+
+            // Roots that get merged across a seam are remembered, so afterwards labels[labels[index]] is the final root
+            // of every candidate without another pass over the image
+            workspace.merged.clear();
+            for (int row = 1; row < rows; row++)
+            {
+                if (workspace.band_starts[row] == 0)
+                    continue;
+                for (int col = 0; col < cols; col++)
+                {
+                    const auto index = row * stride + col;
+                    if (states[index] == canny_none)
+                        continue;
+                    for (int c = std::max(0, col - 1); c <= std::min(cols - 1, col + 1); c++)
+                    {
+                        const auto above = index - stride - col + c;
+                        if (states[above] == canny_none)
+                            continue;
+                        const auto merged_root = unite_labels(labels, strong, index, above);
+                        if (merged_root >= 0)
+                            workspace.merged.push_back(merged_root);
+                    }
+                }
+            }
+            for (const auto root : workspace.merged)
+                labels[root] = find_label(labels, root);
+
+            execution::for_each_row_band(policy, rows, [&](int first_row, int last_row)
+                {
+                    for (int row = first_row; row < last_row; row++)
+                    {
+                        for (auto index = row * stride; index < row * stride + cols; index++)
+                        {
+                            if (states[index] != canny_none)
+                                states[index] = strong[labels[labels[index]]] ? canny_edge : canny_none;
+                        }
+                    }
+                });
+        }
+    }
+
+    // Sobel gradient magnitude of a grayscale image, L2 and in units of the input pixels, thinned to the pixels that
+    // are a maximum across the edge, all other pixels are 0. Like sobel the result is two rows and columns smaller.
+    template<typename ExecutionPolicy, typename T, typename Deleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    array2d<float> non_maximum_suppression(const ExecutionPolicy& policy, const array2d<T, Deleter>& input)
+    {
+        static_assert(pixel_traits<T>::is_grayscale(), "Image must be grayscale.");
+
+        const auto rows = std::max(0, input.rows() - 2);
+        const auto cols = std::max(0, input.cols() - 2);
+        auto result = array2d<float>(rows, cols);
+        if (rows == 0 || cols == 0)
+            return result;
+
+        auto memory = arena(arena::array_bytes<float>(rows, cols) + arena::array_bytes<std::uint8_t>(rows, cols) +
+            arena::array_bytes<float>(input.rows(), input.cols()));
+        auto magnitude = memory.make_array2d<float>(rows, cols);
+        auto sectors = memory.make_array2d<std::uint8_t>(rows, cols);
+        auto pixels = memory.make_array2d<float>(input.rows(), input.cols());
+        internal::convert_pixels(input, pixels);
+
+        execution::for_each_row_band(policy, rows, [&](int first_row, int last_row)
+            {
+                internal::canny_gradients(pixels, magnitude, sectors, first_row, last_row);
+            });
+        execution::for_each_row_band(policy, rows, [&](int first_row, int last_row)
+            {
+                internal::suppress_non_maxima(magnitude, sectors, result.data(), result.stride(), first_row, last_row,
+                    [](float value, bool keep) { return keep ? value : 0.f; });
+            });
+        return result;
+    }
+
+    template<typename T, typename Deleter>
+    array2d<float> non_maximum_suppression(const array2d<T, Deleter>& input)
+    {
+        return non_maximum_suppression(execution::seq, input);
+    }
+
+    // Canny edge map of a grayscale image: 5x5 gaussian smoothing, sobel gradients, non maximum suppression across the
+    // edge and hysteresis between the two thresholds. The thresholds are gradient magnitudes in units of the input
+    // pixels, e.g. 0..1442 for 8-bit images. Edge pixels become 255, all others 0, and the three pixel wide frame that
+    // the gaussian and sobel can not reach is never an edge.
+    template<typename ExecutionPolicy, typename T, typename Deleter, typename OutputDeleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    void canny_into(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, array2d<std::uint8_t, OutputDeleter>& output,
+        canny_workspace& workspace, double low_threshold, double high_threshold, double sigma = 1.4)
+    {
+        static_assert(pixel_traits<T>::is_grayscale(), "Image must be grayscale.");
+        throw_assert(low_threshold <= high_threshold, "Low threshold " << low_threshold << " exceeds high threshold " << high_threshold << ".")
+        throw_assert(sigma > 0, "Sigma must be positive, but was " << sigma << ".")
+
+        internal::check_output_shape(output, input.rows(), input.cols());
+        std::fill(output.begin(), output.end(), internal::canny_none);
+
+        constexpr auto margin = internal::canny_margin;
+        const auto rows = input.rows() - 2 * margin;
+        const auto cols = input.cols() - 2 * margin;
+        if (rows <= 0 || cols <= 0)
+            return;
+
+        // An empty kernel was never built, sigma of the workspace means nothing until then
+        if (workspace.gaussian.height == 0 || workspace.sigma != sigma)
+        {
+            workspace.gaussian = make_gaussian_kernel<float>(5, sigma);
+            workspace.sigma = sigma;
+        }
+        internal::prepare_canny_workspace<T>(workspace, input.rows(), input.cols(), output.stride());
+
+        if constexpr (std::is_same_v<T, float>)
+        {
+            convolve_into(policy, input, workspace.gaussian, workspace.smoothed);
+        }
+        else
+        {
+            // Converted without normalization, so the thresholds keep the units of the input
+            internal::convert_pixels(input, workspace.pixels);
+            convolve_into(policy, workspace.pixels, workspace.gaussian, workspace.smoothed);
+        }
+
+        const auto low = static_cast<float>(low_threshold);
+        const auto high = static_cast<float>(high_threshold);
+        auto* interior = output.data() + static_cast<std::size_t>(margin) * output.stride() + margin;
+        execution::for_each_row_band(policy, rows, [&](int first_row, int last_row)
+            {
+                internal::canny_gradients(workspace.smoothed, workspace.magnitude, workspace.sectors, first_row, last_row);
+            });
+        execution::for_each_row_band(policy, rows, [&](int first_row, int last_row)
+            {
+                internal::canny_suppress(workspace.magnitude, workspace.sectors, low, high, interior, output.stride(), first_row, last_row);
+            });
+
+        internal::canny_hysteresis(policy, output, workspace);
+    }
+
+    template<typename T, typename Deleter, typename OutputDeleter>
+    void canny_into(const array2d<T, Deleter>& input, array2d<std::uint8_t, OutputDeleter>& output, canny_workspace& workspace,
+        double low_threshold, double high_threshold, double sigma = 1.4)
+    {
+        canny_into(execution::seq, input, output, workspace, low_threshold, high_threshold, sigma);
+    }
+
+    template<typename ExecutionPolicy, typename T, typename Deleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    array2d<std::uint8_t> canny(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, double low_threshold, double high_threshold, double sigma = 1.4)
+    {
+        auto workspace = canny_workspace();
+        auto result = array2d<std::uint8_t>(input.rows(), input.cols());
+        canny_into(policy, input, result, workspace, low_threshold, high_threshold, sigma);
+        return result;
+    }
+
+    template<typename T, typename Deleter>
+    array2d<std::uint8_t> canny(const array2d<T, Deleter>& input, double low_threshold, double high_threshold, double sigma = 1.4)
+    {
+        return canny(execution::seq, input, low_threshold, high_threshold, sigma);
+    }
+}
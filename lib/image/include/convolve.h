@@ -1,48 +1,718 @@
 #pragma once
+#include <algorithm>
 #include <array>
+#include <memory>
 #include <utility>
+#include <vector>
+#include "border.h"
+#include "fft_convolve.h"
 #include "kernel.h"
+#include "simd.h"
 
-namespace lib 
+namespace lib
 {
     namespace internal {
         // Helper functions for convolve_window_unrolled
-        template <std::size_t Height, std::size_t Width, typename T, std::size_t... N>
-        constexpr const typename T::value_type col_fold(const typename sliding_window_view<Height, Width, T>::window_type& window, const kernel<Height, Width, typename T::value_type>& kernel, std::size_t row_idx, std::index_sequence<N...>)
+        template <std::size_t Height, std::size_t Width, typename T, typename K, std::size_t... N>
+        constexpr const K col_fold(const typename sliding_window_view<Height, Width, T>::window_type& window, const kernel<Height, Width, K>& kernel, std::size_t row_idx, std::index_sequence<N...>)
         {
             return ((window[row_idx][N] * kernel.values[row_idx * Width + N]) + ...);
         }
 
-        template <std::size_t Height, std::size_t Width, typename T, std::size_t... N>
-        constexpr const typename T::value_type row_fold(const typename sliding_window_view<Height, Width, T>::window_type& window, const kernel<Height, Width, typename T::value_type>& kernel, std::index_sequence<N...>)
+        template <std::size_t Height, std::size_t Width, typename T, typename K, std::size_t... N>
+        constexpr const K row_fold(const typename sliding_window_view<Height, Width, T>::window_type& window, const kernel<Height, Width, K>& kernel, std::index_sequence<N...>)
         {
             return (col_fold<Height, Width, T>(window, kernel, N, std::make_index_sequence<Width>{}) + ...);
         }
+
+        // Helper functions for the separable passes, the input pointer addresses the first tap
+        template <std::size_t Width, typename T, std::size_t... N>
+        constexpr const T horizontal_fold(const T* input, const std::array<T, Width>& row, std::index_sequence<N...>)
+        {
+            return ((input[N] * row[N]) + ...);
+        }
+
+        template <std::size_t Height, typename T, std::size_t... N>
+        constexpr const T vertical_fold(const T* input, std::size_t stride, const std::array<T, Height>& column, std::index_sequence<N...>)
+        {
+            return ((input[N * stride] * column[N]) + ...);
+        }
+
+        // Runs the vectorized kernel of the active instruction set, returns false if T has none or only scalar code is available
+        template <typename T>
+        bool convolve_vectorized(const T* input, std::ptrdiff_t input_stride, T* output, std::ptrdiff_t output_stride,
+            int rows, int cols, const T* kernel, int kernel_rows, int kernel_cols)
+        {
+            if constexpr (simd::is_vectorized_v<T>)
+            {
+                if (auto function = simd::convolve_kernel<T>())
+                {
+                    function(input, input_stride, output, output_stride, rows, cols, kernel, kernel_rows, kernel_cols);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        template <typename T, typename ExecutionPolicy>
+        const ExecutionPolicy& resolve_tiles(const ExecutionPolicy& policy, std::size_t, std::size_t, std::size_t)
+        {
+            return policy;
+        }
+
+        // Fills in tile sizes left at 0: a tile is as wide as fits kernel_rows input row segments into half of L1, so every
+        // segment is still cached when the next output row reuses it, and as high as fits the tile's input and
+        // `buffers` - 1 intermediate copies into half of L2.
+        template <typename T>
+        execution::tiled_policy resolve_tiles(const execution::tiled_policy& policy, std::size_t kernel_rows, std::size_t kernel_cols, std::size_t buffers)
+        {
+            const auto& caches = detect_cache_sizes();
+            constexpr int cache_line = static_cast<int>(64 / sizeof(T)) > 0 ? static_cast<int>(64 / sizeof(T)) : 1;
+
+            auto resolved = policy;
+            if (resolved.tile_cols <= 0)
+            {
+                const auto cols = static_cast<int>(caches.l1d / 2 / (kernel_rows * sizeof(T) * buffers)) - static_cast<int>(kernel_cols - 1);
+                resolved.tile_cols = std::max(cache_line, cols / cache_line * cache_line);
+            }
+            if (resolved.tile_rows <= 0)
+            {
+                const auto footprint = (static_cast<std::size_t>(resolved.tile_cols) + kernel_cols - 1) * sizeof(T) * buffers;
+                const auto rows = static_cast<int>(caches.l2 / 2 / footprint) - static_cast<int>(kernel_rows - 1);
+                resolved.tile_rows = std::max(8, rows);
+            }
+            return resolved;
+        }
+
+        // Output rows per strip of a two pass convolution. The intermediate rows of a strip, its output rows and the
+        // halo rows below them, fit into half of L2, so the second pass reads them back from the cache.
+        template <typename T>
+        int strip_rows(int cols, int halo, std::size_t buffers = 1)
+        {
+            const auto row_bytes = std::max<std::size_t>(1, static_cast<std::size_t>(cols) * sizeof(T) * buffers);
+            const auto rows = static_cast<int>(detect_cache_sizes().l2 / 2 / row_bytes) - halo;
+            return std::max({ 16, 4 * halo, rows });
+        }
+
+        // Intermediate rows of one band, from the shared pool, so they are neither zero filled nor kept after the call
+        template <typename T>
+        pooled_array2d<T> make_band_buffer(int rows, int cols)
+        {
+            return lib::make_pooled_array2d<T>(rows, cols);
+        }
+
+        // Correlates every row with the row factor, output has (cols - (Width - 1)) columns
+        template <std::size_t Width, typename T>
+        void convolve_horizontal(const T* input, std::size_t input_stride, T* output, std::size_t output_stride, int rows, int cols, const std::array<T, Width>& row)
+        {
+            for (int y = 0; y < rows; y++)
+            {
+                const T* input_row = input + y * input_stride;
+                T* output_row = output + y * output_stride;
+                for (int x = 0; x < cols; x++)
+                {
+                    output_row[x] = horizontal_fold<Width>(input_row + x, row, std::make_index_sequence<Width>{});
+                }
+            }
+        }
+
+        // Correlates every column with the column factor, output has (rows - (Height - 1)) rows
+        template <std::size_t Height, typename T>
+        void convolve_vertical(const T* input, std::size_t input_stride, T* output, std::size_t output_stride, int rows, int cols, const std::array<T, Height>& column)
+        {
+            for (int y = 0; y < rows; y++)
+            {
+                const T* input_row = input + y * input_stride;
+                T* output_row = output + y * output_stride;
+                for (int x = 0; x < cols; x++)
+                {
+                    output_row[x] = vertical_fold<Height>(input_row + x, input_stride, column, std::make_index_sequence<Height>{});
+                }
+            }
+        }
     }
 
-    // Calculates one convolution without looping over the kernel
-    template <std::size_t Height, std::size_t Width, typename T>
-    constexpr const typename T::value_type convolve_window_unrolled(
+    // Calculates one convolution without looping over the kernel, accumulating in the kernel's value type
+    template <std::size_t Height, std::size_t Width, typename T, typename K = typename T::value_type>
+    constexpr const K convolve_window_unrolled(
         const typename sliding_window_view<Height, Width, T>::window_type& window,
-        const kernel<Height, Width, typename T::value_type>& kernel)
+        const kernel<Height, Width, K>& kernel)
     {
         return internal::row_fold<Height, Width, T>(window, kernel, std::make_index_sequence<Height>{});
     }
 
+    namespace internal
+    {
+        // Window pixels in row major order, converted to the accumulator type once for all kernels
+        template <std::size_t Height, std::size_t Width, typename T, typename K, std::size_t... N>
+        constexpr std::array<K, Height * Width> load_window(const typename sliding_window_view<Height, Width, T>::window_type& window, std::index_sequence<N...>)
+        {
+            return { { static_cast<K>(window[N / Width][N % Width])... } };
+        }
+
+        template <std::size_t Width, typename K, typename T, std::size_t... N>
+        constexpr std::array<K, sizeof...(N)> load_window(const T* input, std::ptrdiff_t stride, std::index_sequence<N...>)
+        {
+            return { { static_cast<K>(input[(N / Width) * stride + N % Width])... } };
+        }
+
+        template <std::size_t Size, typename K, std::size_t... N>
+        constexpr K dot(const std::array<K, Size>& values, const std::array<K, Size>& coefficients, std::index_sequence<N...>)
+        {
+            return ((values[N] * coefficients[N]) + ...);
+        }
+    }
+
+    // Calculates the convolution with several kernels of the same size while reading the window only once, e.g. both
+    // sobel directions or a compass bank of eight kernels. The responses are returned in the order of the kernels.
+    template <std::size_t Height, std::size_t Width, typename T, typename K, typename... Kernels>
+    constexpr std::array<K, 1 + sizeof...(Kernels)> convolve_window_multi(
+        const typename sliding_window_view<Height, Width, T>::window_type& window,
+        const kernel<Height, Width, K>& first, const Kernels&... rest)
+    {
+        static_assert((std::is_same_v<Kernels, kernel<Height, Width, K>> && ...), "All kernels must have the same size and value type.");
+
+        constexpr auto taps = std::make_index_sequence<Height * Width>{};
+        const auto values = internal::load_window<Height, Width, T, K>(window, taps);
+        return { { internal::dot(values, first.values, taps), internal::dot(values, rest.values, taps)... } };
+    }
+
+    // Two pass convolution (horizontal, then vertical) with Height + Width multiplications per pixel. Every band of rows
+    // runs both passes strip by strip through an intermediate of a few rows, recomputing the Height - 1 rows a strip
+    // shares with the next one, so the memory besides input and output does not grow with the image.
+    template<typename ExecutionPolicy, std::size_t Height, std::size_t Width, typename T, typename Deleter, typename OutputDeleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    void convolve_into(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, const separable_kernel<Height, Width, T>& convolution_kernel,
+        array2d<T, OutputDeleter>& output)
+    {
+        const auto rows = input.rows() - static_cast<int>(Height - 1);
+        const auto cols = input.cols() - static_cast<int>(Width - 1);
+        internal::check_output_shape(output, rows, cols);
+
+        if constexpr (std::is_same_v<ExecutionPolicy, execution::tiled_policy>)
+        {
+            // Both passes run per tile through a tile sized intermediate, which never leaves the cache
+            const auto tiles = internal::resolve_tiles<T>(policy, Height, Width, 2);
+            auto intermediate = internal::make_band_buffer<T>(tiles.tile_rows + static_cast<int>(Height - 1), tiles.tile_cols);
+            const auto buffer_stride = static_cast<std::size_t>(intermediate.stride());
+            auto* buffer = intermediate.data();
+
+            execution::for_each_block(tiles, rows, cols, [&](int first_row, int last_row, int first_col, int last_col)
+                {
+                    const auto tile_input_rows = last_row - first_row + static_cast<int>(Height - 1);
+                    const auto tile_cols = last_col - first_col;
+                    const auto* tile_input = input.data() + static_cast<std::size_t>(first_row) * input.stride() + first_col;
+                    auto* tile_output = output.data() + static_cast<std::size_t>(first_row) * output.stride() + first_col;
+
+                    if (!internal::convolve_vectorized(tile_input, input.stride(), buffer, buffer_stride, tile_input_rows, tile_cols, convolution_kernel.row.data(), 1, static_cast<int>(Width)))
+                        internal::convolve_horizontal<Width>(tile_input, input.stride(), buffer, buffer_stride, tile_input_rows, tile_cols, convolution_kernel.row);
+
+                    if (!internal::convolve_vectorized(buffer, buffer_stride, tile_output, output.stride(), last_row - first_row, tile_cols, convolution_kernel.column.data(), static_cast<int>(Height), 1))
+                        internal::convolve_vertical<Height>(buffer, buffer_stride, tile_output, output.stride(), last_row - first_row, tile_cols, convolution_kernel.column);
+                });
+            return;
+        }
+
+        if (rows <= 0 || cols <= 0)
+            return;
+
+        constexpr auto halo = static_cast<int>(Height - 1);
+        const auto strip = internal::strip_rows<T>(cols, halo);
+        execution::for_each_row_band(policy, rows, [&](int first_row, int last_row)
+            {
+                auto intermediate = internal::make_band_buffer<T>(std::min(strip, last_row - first_row) + halo, cols);
+                const auto intermediate_stride = static_cast<std::size_t>(intermediate.stride());
+                for (auto strip_first = first_row; strip_first < last_row; strip_first += strip)
+                {
+                    const auto strip_last = std::min(last_row, strip_first + strip);
+                    const auto* strip_input = input.data() + static_cast<std::size_t>(strip_first) * input.stride();
+                    auto* strip_output = output.data() + static_cast<std::size_t>(strip_first) * output.stride();
+                    if (!internal::convolve_vectorized(strip_input, input.stride(), intermediate.data(), intermediate_stride, strip_last - strip_first + halo, cols, convolution_kernel.row.data(), 1, static_cast<int>(Width)))
+                        internal::convolve_horizontal<Width>(strip_input, input.stride(), intermediate.data(), intermediate_stride, strip_last - strip_first + halo, cols, convolution_kernel.row);
+
+                    if (!internal::convolve_vectorized(intermediate.data(), intermediate_stride, strip_output, output.stride(), strip_last - strip_first, cols, convolution_kernel.column.data(), static_cast<int>(Height), 1))
+                        internal::convolve_vertical<Height>(intermediate.data(), intermediate_stride, strip_output, output.stride(), strip_last - strip_first, cols, convolution_kernel.column);
+                }
+            });
+    }
+
+    template<std::size_t Height, std::size_t Width, typename T, typename Deleter, typename OutputDeleter>
+    void convolve_into(const array2d<T, Deleter>& input, const separable_kernel<Height, Width, T>& convolution_kernel, array2d<T, OutputDeleter>& output)
+    {
+        convolve_into(execution::seq, input, convolution_kernel, output);
+    }
+
+    template<typename ExecutionPolicy, std::size_t Height, std::size_t Width, typename T, typename Deleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    array2d<T> convolve(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, const separable_kernel<Height, Width, T>& convolution_kernel)
+    {
+        auto result = array2d<T>(input.rows() - static_cast<int>(Height - 1), input.cols() - static_cast<int>(Width - 1));
+        convolve_into(policy, input, convolution_kernel, result);
+        return result;
+    }
+
+    template<std::size_t Height, std::size_t Width, typename T, typename Deleter>
+    array2d<T> convolve(const array2d<T, Deleter>& input, const separable_kernel<Height, Width, T>& convolution_kernel)
+    {
+        return convolve(execution::seq, input, convolution_kernel);
+    }
+
+    // Full size two pass convolution, the few columns and rows whose window leaves the image read through the border
+    // policy while the interior goes through the same code as the shrinking overload
+    template<typename Border, typename ExecutionPolicy, std::size_t Height, std::size_t Width, typename T, typename Deleter, typename OutputDeleter,
+        typename = std::enable_if_t<border::is_border_v<Border> && execution::is_execution_policy_v<ExecutionPolicy>>>
+    void convolve_into(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, const separable_kernel<Height, Width, T>& convolution_kernel,
+        array2d<T, OutputDeleter>& output, const Border& border = Border{})
+    {
+        constexpr auto anchor_rows = static_cast<int>(kernel_traits<kernel<Height, Width, T>>::anchor_row);
+        constexpr auto anchor_cols = static_cast<int>(kernel_traits<kernel<Height, Width, T>>::anchor_col);
+        const auto rows = input.rows();
+        const auto cols = input.cols();
+        const auto top = std::min(anchor_rows, rows);
+        const auto bottom = std::max(top, rows - static_cast<int>(Height - 1) + anchor_rows);
+        const auto left = std::min(anchor_cols, cols);
+        const auto right = std::max(left, cols - static_cast<int>(Width - 1) + anchor_cols);
+        internal::check_output_shape(output, rows, cols);
+
+        if (rows == 0 || cols == 0)
+            return;
+
+        // Horizontal pass of the input rows [first_row, last_row) into the intermediate, the columns whose window leaves
+        // the image read through the border
+        const auto filter_rows = [&](int first_row, int last_row, T* intermediate, std::ptrdiff_t intermediate_stride)
+        {
+            if (right > left)
+            {
+                const auto* band_input = input.data() + static_cast<std::size_t>(first_row) * input.stride();
+                if (!internal::convolve_vectorized(band_input, input.stride(), intermediate + left, intermediate_stride, last_row - first_row, right - left, convolution_kernel.row.data(), 1, static_cast<int>(Width)))
+                    internal::convolve_horizontal<Width>(band_input, input.stride(), intermediate + left, intermediate_stride, last_row - first_row, right - left, convolution_kernel.row);
+            }
+
+            internal::for_each_border_span(first_row, last_row, cols, 0, rows, left, right, [&](int row, int first_col, int last_col)
+                {
+                    for (int col = first_col; col < last_col; col++)
+                    {
+                        auto accumulator = T{};
+                        for (int c = 0; c < static_cast<int>(Width); c++)
+                            accumulator += internal::border_sample(input.data(), input.stride(), rows, cols, row, col + c - anchor_cols, border) * convolution_kernel.row[c];
+                        intermediate[(row - first_row) * intermediate_stride + col] = accumulator;
+                    }
+                });
+        };
+
+        constexpr auto halo = static_cast<int>(Height - 1);
+        const auto strip = internal::strip_rows<T>(cols, halo);
+        execution::for_each_row_band(policy, rows, [&](int first_row, int last_row)
+            {
+                // The interior rows read only rows of the image, strip by strip like the shrinking overload
+                const auto first_inner = std::max(first_row, top);
+                const auto last_inner = std::min(last_row, bottom);
+                if (last_inner > first_inner)
+                {
+                    auto intermediate = internal::make_band_buffer<T>(std::min(strip, last_inner - first_inner) + halo, cols);
+                    for (auto strip_first = first_inner; strip_first < last_inner; strip_first += strip)
+                    {
+                        const auto strip_last = std::min(last_inner, strip_first + strip);
+                        filter_rows(strip_first - anchor_rows, strip_last - anchor_rows + halo, intermediate.data(), intermediate.stride());
+
+                        auto* strip_output = output.data() + static_cast<std::size_t>(strip_first) * output.stride();
+                        if (!internal::convolve_vectorized(intermediate.data(), intermediate.stride(), strip_output, output.stride(), strip_last - strip_first, cols, convolution_kernel.column.data(), static_cast<int>(Height), 1))
+                            internal::convolve_vertical<Height>(intermediate.data(), intermediate.stride(), strip_output, output.stride(), strip_last - strip_first, cols, convolution_kernel.column);
+                    }
+                }
+
+                // The at most Height - 1 rows at the top and bottom filter the rows they reach through the border one by
+                // one, outside the image every row of a constant border filters to value * sum(row)
+                internal::for_each_border_span(first_row, last_row, cols, top, bottom, 0, cols, [&](int row, int first_col, int last_col)
+                    {
+                        if (first_col == last_col)
+                            return;
+
+                        auto filtered = internal::make_band_buffer<T>(1, cols);
+                        auto* output_row = output.data() + static_cast<std::size_t>(row) * output.stride();
+                        std::fill(output_row, output_row + cols, T{});
+                        for (int r = 0; r < static_cast<int>(Height); r++)
+                        {
+                            const auto source = row + r - anchor_rows;
+                            if constexpr (std::is_same_v<Border, border::constant>)
+                            {
+                                if (source < 0 || source >= rows)
+                                {
+                                    auto value = T{};
+                                    for (const auto& coefficient : convolution_kernel.row)
+                                        value += static_cast<T>(border.value) * coefficient;
+                                    std::fill(filtered.data(), filtered.data() + cols, value);
+                                }
+                                else
+                                {
+                                    filter_rows(source, source + 1, filtered.data(), filtered.stride());
+                                }
+                            }
+                            else
+                            {
+                                const auto mapped = Border::map(source, rows);
+                                filter_rows(mapped, mapped + 1, filtered.data(), filtered.stride());
+                            }
+
+                            for (int col = 0; col < cols; col++)
+                                output_row[col] += filtered.data()[col] * convolution_kernel.column[r];
+                        }
+                    });
+            });
+    }
+
+    template<typename Border, std::size_t Height, std::size_t Width, typename T, typename Deleter, typename OutputDeleter,
+        typename = std::enable_if_t<border::is_border_v<Border>>>
+    void convolve_into(const array2d<T, Deleter>& input, const separable_kernel<Height, Width, T>& convolution_kernel, array2d<T, OutputDeleter>& output,
+        const Border& border = Border{})
+    {
+        convolve_into<Border>(execution::seq, input, convolution_kernel, output, border);
+    }
+
+    template<typename Border, typename ExecutionPolicy, std::size_t Height, std::size_t Width, typename T, typename Deleter,
+        typename = std::enable_if_t<border::is_border_v<Border> && execution::is_execution_policy_v<ExecutionPolicy>>>
+    array2d<T> convolve(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, const separable_kernel<Height, Width, T>& convolution_kernel,
+        const Border& border = Border{})
+    {
+        auto result = array2d<T>(input.rows(), input.cols());
+        convolve_into<Border>(policy, input, convolution_kernel, result, border);
+        return result;
+    }
+
+    template<typename Border, std::size_t Height, std::size_t Width, typename T, typename Deleter,
+        typename = std::enable_if_t<border::is_border_v<Border>>>
+    array2d<T> convolve(const array2d<T, Deleter>& input, const separable_kernel<Height, Width, T>& convolution_kernel, const Border& border = Border{})
+    {
+        return convolve<Border>(execution::seq, input, convolution_kernel, border);
+    }
+
+    namespace internal
+    {
+        // Computes the output block [first_row, last_row) x [first_col, last_col) of a full 2D convolution, output addresses
+        // the first output pixel and is not necessarily part of an array2d of the output size
+        template<std::size_t Height, std::size_t Width, typename T, typename Deleter>
+        void convolve_block(const array2d<T, Deleter>& input, const kernel<Height, Width, T>& convolution_kernel,
+            T* output, std::ptrdiff_t output_stride, int first_row, int last_row, int first_col, int last_col)
+        {
+            if (convolve_vectorized(input.data() + static_cast<std::size_t>(first_row) * input.stride() + first_col, input.stride(),
+                output + first_row * output_stride + first_col, output_stride, last_row - first_row, last_col - first_col,
+                convolution_kernel.values.data(), static_cast<int>(Height), static_cast<int>(Width)))
+                return;
+
+            auto view = lib::make_sliding_window_view<Height, Width>(input);
+            const auto view_cols = static_cast<std::size_t>(input.cols() - static_cast<int>(Width - 1));
+            for (auto row = first_row; row < last_row; row++)
+            {
+                auto* output_row = output + row * output_stride;
+                for (auto col = first_col; col < last_col; col++)
+                    output_row[col] = convolve_window_unrolled<Height, Width, const array2d<T, Deleter>>(view[row * view_cols + col], convolution_kernel);
+            }
+        }
+
+        // Computes the pixels of the full size output rows [first_row, last_row) whose window leaves the image
+        template<typename Border, std::size_t Height, std::size_t Width, typename T, typename Deleter, typename OutputDeleter>
+        void convolve_border_rows(const array2d<T, Deleter>& input, const kernel<Height, Width, T>& convolution_kernel, const Border& border,
+            array2d<T, OutputDeleter>& output, int first_row, int last_row)
+        {
+            constexpr auto anchor_rows = static_cast<int>(kernel_traits<kernel<Height, Width, T>>::anchor_row);
+            constexpr auto anchor_cols = static_cast<int>(kernel_traits<kernel<Height, Width, T>>::anchor_col);
+            const auto rows = input.rows();
+            const auto cols = input.cols();
+            const auto top = std::min(anchor_rows, rows);
+            const auto left = std::min(anchor_cols, cols);
+            const auto bottom = std::max(top, rows - static_cast<int>(Height - 1) + anchor_rows);
+            const auto right = std::max(left, cols - static_cast<int>(Width - 1) + anchor_cols);
+
+            for_each_border_span(first_row, last_row, cols, top, bottom, left, right,
+                [&](int row, int first_col, int last_col)
+                {
+                    for (int col = first_col; col < last_col; col++)
+                    {
+                        auto accumulator = T{};
+                        for (int r = 0; r < static_cast<int>(Height); r++)
+                        {
+                            for (int c = 0; c < static_cast<int>(Width); c++)
+                                accumulator += border_sample(input.data(), input.stride(), rows, cols, row + r - anchor_rows, col + c - anchor_cols, border) * convolution_kernel.values[r * Width + c];
+                        }
+                        output.data()[static_cast<std::size_t>(row) * output.stride() + col] = accumulator;
+                    }
+                });
+        }
+    }
+
+    template<typename ExecutionPolicy, std::size_t Height, std::size_t Width, typename T, typename Deleter, typename OutputDeleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    void convolve_into(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, const kernel<Height, Width, T>& convolution_kernel,
+        array2d<T, OutputDeleter>& output)
+    {
+
+        if constexpr (Height > 1 && Width > 1)
+        {
+            // Rank-1 kernels like gaussian_blur or sobel are cheaper to apply as two 1D passes
+            if (is_separable(convolution_kernel))
+                return convolve_into(policy, input, separate(convolution_kernel), output);
+        }
+
+        // Large kernels are cheaper in the frequency domain
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            if (internal::prefer_fft<T>(input.rows(), input.cols(), static_cast<int>(Height), static_cast<int>(Width)))
+                return fft_convolve_into(policy, input, convolution_kernel, output);
+        }
+
+        internal::check_output_shape(output, input.rows() - static_cast<int>(Height - 1), input.cols() - static_cast<int>(Width - 1));
+        execution::for_each_block(internal::resolve_tiles<T>(policy, Height, Width, 1), output.rows(), output.cols(),
+            [&](int first_row, int last_row, int first_col, int last_col)
+            {
+                internal::convolve_block(input, convolution_kernel, output.data(), output.stride(), first_row, last_row, first_col, last_col);
+            });
+    }
+
+    template<std::size_t Height, std::size_t Width, typename T, typename Deleter, typename OutputDeleter>
+    void convolve_into(const array2d<T, Deleter>& input, const kernel<Height, Width, T>& convolution_kernel, array2d<T, OutputDeleter>& output)
+    {
+        convolve_into(execution::seq, input, convolution_kernel, output);
+    }
+
+    template<typename ExecutionPolicy, std::size_t Height, std::size_t Width, typename T, typename Deleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    array2d<T> convolve(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, const kernel<Height, Width, T>& convolution_kernel)
+    {
+        auto result = array2d<T>(input.rows() - static_cast<int>(Height - 1), input.cols() - static_cast<int>(Width - 1));
+        convolve_into(policy, input, convolution_kernel, result);
+        return result;
+    }
+
     template<std::size_t Height, std::size_t Width, typename T, typename Deleter>
     array2d<T> convolve(const array2d<T, Deleter>& input, const kernel<Height, Width, T>& convolution_kernel)
     {
-        static_assert(Height % 2 == 1, "Height must be an uneven number.");
-        static_assert(Width % 2 == 1, "Width must be an uneven number.");
+        return convolve(execution::seq, input, convolution_kernel);
+    }
 
-        auto result = array2d<typename std::remove_const<T>::type>(input.rows() - (Height - 1), input.cols() - (Width - 1));
+    // Full size convolution, see the separable overload
+    template<typename Border, typename ExecutionPolicy, std::size_t Height, std::size_t Width, typename T, typename Deleter, typename OutputDeleter,
+        typename = std::enable_if_t<border::is_border_v<Border> && execution::is_execution_policy_v<ExecutionPolicy>>>
+    void convolve_into(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, const kernel<Height, Width, T>& convolution_kernel,
+        array2d<T, OutputDeleter>& output, const Border& border = Border{})
+    {
+        if constexpr (Height > 1 && Width > 1)
+        {
+            if (is_separable(convolution_kernel))
+                return convolve_into<Border>(policy, input, separate(convolution_kernel), output, border);
+        }
 
-        auto result_iterator = result.begin();
-        for (auto& it : lib::make_sliding_window_view<Height, Width>(input))
+        internal::check_output_shape(output, input.rows(), input.cols());
+        const auto inner_rows = input.rows() - static_cast<int>(Height - 1);
+        const auto inner_cols = input.cols() - static_cast<int>(Width - 1);
+        if (inner_rows > 0 && inner_cols > 0)
         {
-            *result_iterator = convolve_window_unrolled<Height, Width, const array2d<T, Deleter>>(it, convolution_kernel);
-            result_iterator++;
+            auto* interior = output.data() + kernel_traits<kernel<Height, Width, T>>::anchor_row * output.stride()
+                + kernel_traits<kernel<Height, Width, T>>::anchor_col;
+            execution::for_each_block(internal::resolve_tiles<T>(policy, Height, Width, 1), inner_rows, inner_cols,
+                [&](int first_row, int last_row, int first_col, int last_col)
+                {
+                    internal::convolve_block(input, convolution_kernel, interior, output.stride(), first_row, last_row, first_col, last_col);
+                });
         }
+
+        execution::for_each_row_band(policy, output.rows(), [&](int first_row, int last_row)
+            {
+                internal::convolve_border_rows(input, convolution_kernel, border, output, first_row, last_row);
+            });
+    }
+
+    template<typename Border, std::size_t Height, std::size_t Width, typename T, typename Deleter, typename OutputDeleter,
+        typename = std::enable_if_t<border::is_border_v<Border>>>
+    void convolve_into(const array2d<T, Deleter>& input, const kernel<Height, Width, T>& convolution_kernel, array2d<T, OutputDeleter>& output,
+        const Border& border = Border{})
+    {
+        convolve_into<Border>(execution::seq, input, convolution_kernel, output, border);
+    }
+
+    template<typename Border, typename ExecutionPolicy, std::size_t Height, std::size_t Width, typename T, typename Deleter,
+        typename = std::enable_if_t<border::is_border_v<Border> && execution::is_execution_policy_v<ExecutionPolicy>>>
+    array2d<T> convolve(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, const kernel<Height, Width, T>& convolution_kernel,
+        const Border& border = Border{})
+    {
+        auto result = array2d<T>(input.rows(), input.cols());
+        convolve_into<Border>(policy, input, convolution_kernel, result, border);
         return result;
     }
+
+    template<typename Border, std::size_t Height, std::size_t Width, typename T, typename Deleter,
+        typename = std::enable_if_t<border::is_border_v<Border>>>
+    array2d<T> convolve(const array2d<T, Deleter>& input, const kernel<Height, Width, T>& convolution_kernel, const Border& border = Border{})
+    {
+        return convolve<Border>(execution::seq, input, convolution_kernel, border);
+    }
+
+    namespace internal
+    {
+        // Kernel sizes with a precompiled unrolled convolution, other sizes take the generic loop
+        using unrolled_kernel_sizes = std::index_sequence<3, 5, 7, 9, 11>;
+
+        template<std::size_t Size, typename ExecutionPolicy, typename T, typename Deleter, typename OutputDeleter>
+        bool convolve_unrolled(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, const dynamic_kernel<T>& convolution_kernel,
+            array2d<T, OutputDeleter>& output)
+        {
+            if (convolution_kernel.height != static_cast<int>(Size) || convolution_kernel.width != static_cast<int>(Size))
+                return false;
+
+            auto fixed_kernel = kernel<Size, Size, T>();
+            std::copy(convolution_kernel.values.begin(), convolution_kernel.values.end(), fixed_kernel.values.begin());
+            convolve_into(policy, input, fixed_kernel, output);
+            return true;
+        }
+
+        template<typename ExecutionPolicy, typename T, typename Deleter, typename OutputDeleter, std::size_t... Sizes>
+        bool convolve_unrolled(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, const dynamic_kernel<T>& convolution_kernel,
+            array2d<T, OutputDeleter>& output, std::index_sequence<Sizes...>)
+        {
+            return (convolve_unrolled<Sizes>(policy, input, convolution_kernel, output) || ...);
+        }
+
+        // Computes the output block [first_row, last_row) x [first_col, last_col) for a kernel of any size
+        template<typename T, typename Deleter>
+        void convolve_block(const array2d<T, Deleter>& input, const dynamic_kernel<T>& convolution_kernel,
+            T* output, std::ptrdiff_t output_stride, int first_row, int last_row, int first_col, int last_col)
+        {
+            if (convolve_vectorized(input.data() + static_cast<std::size_t>(first_row) * input.stride() + first_col, input.stride(),
+                output + first_row * output_stride + first_col, output_stride, last_row - first_row, last_col - first_col,
+                convolution_kernel.values.data(), convolution_kernel.height, convolution_kernel.width))
+                return;
+
+            for (auto row = first_row; row < last_row; row++)
+            {
+                auto* output_row = output + row * output_stride;
+                for (auto col = first_col; col < last_col; col++)
+                {
+                    auto accumulator = T{};
+                    for (int r = 0; r < convolution_kernel.height; r++)
+                    {
+                        const auto* input_row = input.data() + static_cast<std::size_t>(row + r) * input.stride() + col;
+                        const auto* coefficients = convolution_kernel.values.data() + static_cast<std::size_t>(r) * convolution_kernel.width;
+                        for (int c = 0; c < convolution_kernel.width; c++)
+                            accumulator += input_row[c] * coefficients[c];
+                    }
+                    output_row[col] = accumulator;
+                }
+            }
+        }
+    }
+
+    // Square kernels of the common sizes are dispatched to the compile time sized convolution, including its separable
+    // fast path, everything else runs a loop over the runtime kernel size
+    template<typename ExecutionPolicy, typename T, typename Deleter, typename OutputDeleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    void convolve_into(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, const dynamic_kernel<T>& convolution_kernel, array2d<T, OutputDeleter>& output)
+    {
+        throw_assert(convolution_kernel.height > 0 && convolution_kernel.width > 0,
+            "Kernel size must be positive, but was " << convolution_kernel.height << "x" << convolution_kernel.width << ".")
+
+        if (internal::convolve_unrolled(policy, input, convolution_kernel, output, internal::unrolled_kernel_sizes{}))
+            return;
+
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            if (internal::prefer_fft<T>(input.rows(), input.cols(), convolution_kernel.height, convolution_kernel.width))
+                return fft_convolve_into(policy, input, convolution_kernel, output);
+        }
+
+        internal::check_output_shape(output, input.rows() - (convolution_kernel.height - 1), input.cols() - (convolution_kernel.width - 1));
+        const auto kernel_rows = static_cast<std::size_t>(convolution_kernel.height);
+        const auto kernel_cols = static_cast<std::size_t>(convolution_kernel.width);
+        execution::for_each_block(internal::resolve_tiles<T>(policy, kernel_rows, kernel_cols, 1), output.rows(), output.cols(),
+            [&](int first_row, int last_row, int first_col, int last_col)
+            {
+                internal::convolve_block(input, convolution_kernel, output.data(), output.stride(), first_row, last_row, first_col, last_col);
+            });
+    }
+
+    template<typename T, typename Deleter, typename OutputDeleter>
+    void convolve_into(const array2d<T, Deleter>& input, const dynamic_kernel<T>& convolution_kernel, array2d<T, OutputDeleter>& output)
+    {
+        convolve_into(execution::seq, input, convolution_kernel, output);
+    }
+
+    template<typename ExecutionPolicy, typename T, typename Deleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    array2d<T> convolve(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, const dynamic_kernel<T>& convolution_kernel)
+    {
+        auto result = array2d<T>(input.rows() - (convolution_kernel.height - 1), input.cols() - (convolution_kernel.width - 1));
+        convolve_into(policy, input, convolution_kernel, result);
+        return result;
+    }
+
+    template<typename T, typename Deleter>
+    array2d<T> convolve(const array2d<T, Deleter>& input, const dynamic_kernel<T>& convolution_kernel)
+    {
+        return convolve(execution::seq, input, convolution_kernel);
+    }
+
+    namespace internal
+    {
+        // Computes the output rows [first_row, last_row) of every kernel, each window is loaded once for the whole bank
+        template<std::size_t Height, std::size_t Width, typename T, std::size_t N>
+        void convolve_multi_block(const T* input, std::ptrdiff_t input_stride, const std::array<kernel<Height, Width, T>, N>& kernels,
+            const std::array<T*, N>& outputs, const std::array<std::ptrdiff_t, N>& output_strides, int first_row, int last_row, int first_col, int last_col)
+        {
+            constexpr auto taps = std::make_index_sequence<Height * Width>{};
+            for (auto row = first_row; row < last_row; row++)
+            {
+                for (auto col = first_col; col < last_col; col++)
+                {
+                    const auto values = load_window<Width, T>(input + row * input_stride + col, input_stride, taps);
+                    for (std::size_t k = 0; k < N; k++)
+                        outputs[k][row * output_strides[k] + col] = dot(values, kernels[k].values, taps);
+                }
+            }
+        }
+    }
+
+    // Valid region convolution of one image with a bank of kernels, outputs[k] receives the response to kernels[k]
+    template<typename ExecutionPolicy, std::size_t Height, std::size_t Width, typename T, std::size_t N, typename Deleter, typename OutputDeleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    void convolve_multi_into(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, const std::array<kernel<Height, Width, T>, N>& kernels,
+        std::array<array2d<T, OutputDeleter>, N>& outputs)
+    {
+        const auto rows = input.rows() - static_cast<int>(Height - 1);
+        const auto cols = input.cols() - static_cast<int>(Width - 1);
+        auto output_data = std::array<T*, N>();
+        auto output_strides = std::array<std::ptrdiff_t, N>();
+        for (std::size_t k = 0; k < N; k++)
+        {
+            internal::check_output_shape(outputs[k], rows, cols);
+            output_data[k] = outputs[k].data();
+            output_strides[k] = outputs[k].stride();
+        }
+
+        execution::for_each_block(internal::resolve_tiles<T>(policy, Height, Width, N), rows, cols,
+            [&](int first_row, int last_row, int first_col, int last_col)
+            {
+                internal::convolve_multi_block(input.data(), input.stride(), kernels, output_data, output_strides, first_row, last_row, first_col, last_col);
+            });
+    }
+
+    template<std::size_t Height, std::size_t Width, typename T, std::size_t N, typename Deleter, typename OutputDeleter>
+    void convolve_multi_into(const array2d<T, Deleter>& input, const std::array<kernel<Height, Width, T>, N>& kernels, std::array<array2d<T, OutputDeleter>, N>& outputs)
+    {
+        convolve_multi_into(execution::seq, input, kernels, outputs);
+    }
+
+    template<typename ExecutionPolicy, std::size_t Height, std::size_t Width, typename T, std::size_t N, typename Deleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    std::array<array2d<T>, N> convolve_multi(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, const std::array<kernel<Height, Width, T>, N>& kernels)
+    {
+        auto outputs = std::array<array2d<T>, N>();
+        for (auto& output : outputs)
+            output = array2d<T>(input.rows() - static_cast<int>(Height - 1), input.cols() - static_cast<int>(Width - 1));
+        convolve_multi_into(policy, input, kernels, outputs);
+        return outputs;
+    }
+
+    template<std::size_t Height, std::size_t Width, typename T, std::size_t N, typename Deleter>
+    std::array<array2d<T>, N> convolve_multi(const array2d<T, Deleter>& input, const std::array<kernel<Height, Width, T>, N>& kernels)
+    {
+        return convolve_multi(execution::seq, input, kernels);
+    }
 }
\ No newline at end of file
@@ -1,10 +1,14 @@
 #pragma once
+#include <core/core.h>
 #include <complex>
 #include <vector>
+#include <algorithm>
 #include <cmath>
+#include <utility>
 
 namespace lib
 {
+    // Reference O(n^2) transform, works for every size: output[k] = sum input[t] * e^(-2 pi i t k / n)
     template<typename T, typename = std::enable_if_t< std::is_floating_point<T>::value>>
     std::vector<std::complex<T>> naive_dft(const std::vector<std::complex<T>> & input)
     {
@@ -14,11 +18,260 @@ namespace lib
         {
             for (size_t t = 0; t < n; t++)
             {
-                auto angle = 2 * M_PI * t * k / n;
-                auto frequency_contribution = std::polar(1., angle);
-                output[k] += frequency_contribution;
+                auto angle = -2 * M_PI * static_cast<double>((t * k) % n) / n;
+                output[k] += input[t] * std::polar(T{ 1 }, static_cast<T>(angle));
             }
         }
         return output;
     }
-}
\ No newline at end of file
+
+    constexpr bool is_power_of_two(std::size_t n)
+    {
+        return n > 0 && (n & (n - 1)) == 0;
+    }
+
+    constexpr std::size_t next_power_of_two(std::size_t n)
+    {
+        std::size_t power = 1;
+        while (power < n)
+            power <<= 1;
+        return power;
+    }
+
+    namespace internal
+    {
+        // Plain complex product, std::complex::operator* goes through a slow library call to handle infinities
+        template<typename T>
+        inline std::complex<T> multiply(const std::complex<T>& a, const std::complex<T>& b)
+        {
+            return std::complex<T>(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+        }
+    }
+
+    // Iterative radix-2 transform of a power of two size. Twiddle factors and the bit reversal permutation
+    // are computed once, so a plan should be reused for all transforms of the same size. With columns > 1 the
+    // data is an n x columns row major matrix whose columns are transformed independently.
+    template<typename T, typename = std::enable_if_t<std::is_floating_point<T>::value>>
+    class fft_plan
+    {
+        std::size_t n_;
+        std::vector<std::complex<T>> twiddles_;     // e^(-2 pi i k / n) for k < n / 2
+        std::vector<std::complex<T>> inverse_twiddles_;
+        std::vector<std::size_t> reversed_;
+
+        void transform_single(std::complex<T>* data, const std::vector<std::complex<T>>& twiddles) const
+        {
+            for (std::size_t i = 0; i < n_; i++)
+            {
+                if (i < reversed_[i])
+                    std::swap(data[i], data[reversed_[i]]);
+            }
+
+            for (std::size_t length = 2; length <= n_; length <<= 1)
+            {
+                const auto half = length / 2;
+                const auto step = n_ / length;
+                for (std::size_t first = 0; first < n_; first += length)
+                {
+                    for (std::size_t k = 0; k < half; k++)
+                    {
+                        const auto product = internal::multiply(data[first + k + half], twiddles[k * step]);
+                        data[first + k + half] = data[first + k] - product;
+                        data[first + k] += product;
+                    }
+                }
+            }
+        }
+
+        // Transforms the columns of an n x columns row major matrix at once, every butterfly combines two whole rows
+        template<bool Inverse>
+        void transform(std::complex<T>* data, std::size_t columns) const
+        {
+            const auto& twiddles = Inverse ? inverse_twiddles_ : twiddles_;
+            if (columns == 1)
+            {
+                transform_single(data, twiddles);
+                return;
+            }
+
+            for (std::size_t i = 0; i < n_; i++)
+            {
+                if (i < reversed_[i])
+                    std::swap_ranges(data + i * columns, data + (i + 1) * columns, data + reversed_[i] * columns);
+            }
+
+            for (std::size_t length = 2; length <= n_; length <<= 1)
+            {
+                const auto half = length / 2;
+                const auto step = n_ / length;
+                for (std::size_t first = 0; first < n_; first += length)
+                {
+                    for (std::size_t k = 0; k < half; k++)
+                    {
+                        const auto twiddle = twiddles[k * step];
+                        auto* even = data + (first + k) * columns;
+                        auto* odd = data + (first + k + half) * columns;
+                        for (std::size_t c = 0; c < columns; c++)
+                        {
+                            const auto product = internal::multiply(odd[c], twiddle);
+                            odd[c] = even[c] - product;
+                            even[c] += product;
+                        }
+                    }
+                }
+            }
+        }
+
+    public:
+        explicit fft_plan(std::size_t n) :
+            n_(n),
+            twiddles_(n / 2),
+            inverse_twiddles_(n / 2),
+            reversed_(n)
+        {
+            throw_assert(is_power_of_two(n), "FFT size must be a power of two, but was " << n << ".")
+
+            for (std::size_t k = 0; k < n / 2; k++)
+            {
+                twiddles_[k] = std::polar(T{ 1 }, static_cast<T>(-2 * M_PI * static_cast<double>(k) / n));
+                inverse_twiddles_[k] = std::conj(twiddles_[k]);
+            }
+
+            std::size_t bits = 0;
+            while ((std::size_t{ 1 } << bits) < n)
+                bits++;
+            for (std::size_t i = 0; i < n; i++)
+            {
+                std::size_t reversed = 0;
+                for (std::size_t bit = 0; bit < bits; bit++)
+                    reversed |= ((i >> bit) & 1) << (bits - 1 - bit);
+                reversed_[i] = reversed;
+            }
+        }
+
+        std::size_t size() const
+        {
+            return n_;
+        }
+
+        void forward(std::complex<T>* data, std::size_t columns = 1) const
+        {
+            transform<false>(data, columns);
+        }
+
+        // Includes the 1 / n normalization, so inverse(forward(x)) == x
+        void inverse(std::complex<T>* data, std::size_t columns = 1) const
+        {
+            transform<true>(data, columns);
+            const auto scale = T{ 1 } / static_cast<T>(n_);
+            for (std::size_t i = 0; i < n_ * columns; i++)
+                data[i] *= scale;
+        }
+    };
+
+    // Transform of n real values through one complex transform of size n / 2. Only the n / 2 + 1 non redundant
+    // bins are stored, the others are their complex conjugates.
+    template<typename T, typename = std::enable_if_t<std::is_floating_point<T>::value>>
+    class real_fft_plan
+    {
+        std::size_t n_;
+        fft_plan<T> half_;
+        std::vector<std::complex<T>> twiddles_;     // e^(-2 pi i k / n) for k < n / 2
+
+    public:
+        explicit real_fft_plan(std::size_t n) :
+            n_(n),
+            half_(n / 2),
+            twiddles_(n / 2)
+        {
+            throw_assert(n >= 2 && is_power_of_two(n), "Real FFT size must be a power of two of at least 2, but was " << n << ".")
+
+            for (std::size_t k = 0; k < n / 2; k++)
+                twiddles_[k] = std::polar(T{ 1 }, static_cast<T>(-2 * M_PI * static_cast<double>(k) / n));
+        }
+
+        std::size_t size() const
+        {
+            return n_;
+        }
+
+        std::size_t bins() const
+        {
+            return n_ / 2 + 1;
+        }
+
+        // Reads n values from input and writes n / 2 + 1 bins to output. With columns > 1 the input is an
+        // n x columns and the output an (n / 2 + 1) x columns row major matrix, transformed column by column.
+        void forward(const T* input, std::complex<T>* output, std::size_t columns = 1) const
+        {
+            const auto half = n_ / 2;
+            for (std::size_t k = 0; k < half; k++)
+            {
+                for (std::size_t c = 0; c < columns; c++)
+                    output[k * columns + c] = std::complex<T>(input[2 * k * columns + c], input[(2 * k + 1) * columns + c]);
+            }
+            half_.forward(output, columns);
+            std::copy_n(output, columns, output + half * columns);
+
+            // Split the packed transform into the spectra of the even and the odd samples
+            for (std::size_t k = 0; k <= half / 2; k++)
+            {
+                const auto twiddle = twiddles_[k];
+                const auto mirror_twiddle = k == 0 ? std::complex<T>(-1, 0) : twiddles_[half - k];
+                auto* row = output + k * columns;
+                auto* mirror_row = output + (half - k) * columns;
+                for (std::size_t c = 0; c < columns; c++)
+                {
+                    const auto z = row[c];
+                    const auto mirror = mirror_row[c];
+                    const auto even = (z + std::conj(mirror)) * T{ 0.5 };
+                    const auto odd = z - std::conj(mirror);
+                    const auto even_mirror = (mirror + std::conj(z)) * T{ 0.5 };
+                    const auto odd_mirror = mirror - std::conj(z);
+
+                    // odd * -i / 2
+                    row[c] = even + internal::multiply(twiddle, std::complex<T>(odd.imag() * T{ 0.5 }, -odd.real() * T{ 0.5 }));
+                    if (half - k != k)
+                        mirror_row[c] = even_mirror + internal::multiply(mirror_twiddle, std::complex<T>(odd_mirror.imag() * T{ 0.5 }, -odd_mirror.real() * T{ 0.5 }));
+                }
+            }
+        }
+
+        // Reads n / 2 + 1 bins from input, which is used as scratch space, and writes n values to output
+        void inverse(std::complex<T>* input, T* output, std::size_t columns = 1) const
+        {
+            const auto half = n_ / 2;
+            for (std::size_t k = 0; k <= half / 2; k++)
+            {
+                const auto twiddle = std::conj(twiddles_[k]);
+                const auto mirror_twiddle = k == 0 ? std::complex<T>(-1, 0) : std::conj(twiddles_[half - k]);
+                auto* row = input + k * columns;
+                auto* mirror_row = input + (half - k) * columns;
+                for (std::size_t c = 0; c < columns; c++)
+                {
+                    const auto x = row[c];
+                    const auto mirror = mirror_row[c];
+                    const auto even = (x + std::conj(mirror)) * T{ 0.5 };
+                    const auto odd = internal::multiply((x - std::conj(mirror)) * T{ 0.5 }, twiddle);
+                    const auto even_mirror = (mirror + std::conj(x)) * T{ 0.5 };
+                    const auto odd_mirror = internal::multiply((mirror - std::conj(x)) * T{ 0.5 }, mirror_twiddle);
+
+                    // even + i * odd
+                    row[c] = even + std::complex<T>(-odd.imag(), odd.real());
+                    if (half - k != k)
+                        mirror_row[c] = even_mirror + std::complex<T>(-odd_mirror.imag(), odd_mirror.real());
+                }
+            }
+
+            half_.inverse(input, columns);
+            for (std::size_t k = 0; k < half; k++)
+            {
+                for (std::size_t c = 0; c < columns; c++)
+                {
+                    output[2 * k * columns + c] = input[k * columns + c].real();
+                    output[(2 * k + 1) * columns + c] = input[k * columns + c].imag();
+                }
+            }
+        }
+    };
+}
@@ -1,35 +1,625 @@
 #pragma once
 #include <core/core.h>
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include "border.h"
 #include "kernel.h"
 #include "convolve.h"
 #include "pixel.h"
+#include "image_converter.h"
+#include "magnitude.h"
+#include "simd.h"
 
 namespace lib
 {
+    namespace internal
+    {
+        // Computes the output rows [first_row, last_row) of the gradient magnitude, output addresses the first output pixel
+        template<typename T, typename Deleter>
+        void sobel_rows(const array2d<T, Deleter>& input, typename std::remove_const<T>::type* output, std::ptrdiff_t output_stride, int first_row, int last_row,
+            magnitude_mode magnitude)
+        {
+            const auto cols = input.cols() - 2;
+            if constexpr (simd::is_vectorized_v<T>)
+            {
+                if (auto function = simd::sobel_kernel<T>(); function && has_vector_magnitude<T>(magnitude))
+                {
+                    function(input.data() + static_cast<std::size_t>(first_row) * input.stride(), input.stride(),
+                        output + first_row * output_stride, output_stride, last_row - first_row, cols, magnitude);
+                    return;
+                }
+            }
+
+            using gradient = gradient_type<T>;
+            auto view = lib::make_sliding_window_view<3, 3>(input);
+
+            dispatch_magnitude(magnitude, [&](auto mode)
+                {
+                    for (auto row = first_row; row < last_row; row++)
+                    {
+                        auto* output_row = output + row * output_stride;
+                        for (auto col = 0; col < cols; col++)
+                        {
+                            const auto window = view[static_cast<std::size_t>(row) * cols + col];
+                            const auto gradients = convolve_window_multi<3, 3, const array2d<T, Deleter>>(window, kernels::sobel_h<gradient>, kernels::sobel_v<gradient>);
+
+                            output_row[col] = gradient_magnitude<T, decltype(mode)::value>(gradients[0], gradients[1]);
+                        }
+                    }
+                });
+        }
+
+        // Gradient magnitude of one output row, input addresses the top left pixel of the first window
+        template<typename T>
+        void sobel_row(const T* input, std::ptrdiff_t input_stride, T* output, int cols, magnitude_mode magnitude)
+        {
+            if constexpr (simd::is_vectorized_v<T>)
+            {
+                if (auto function = simd::sobel_kernel<T>(); function && has_vector_magnitude<T>(magnitude))
+                {
+                    function(input, input_stride, output, 0, 1, cols, magnitude);
+                    return;
+                }
+            }
+
+            using gradient = gradient_type<T>;
+            constexpr auto taps = std::make_index_sequence<9>{};
+            dispatch_magnitude(magnitude, [&](auto mode)
+                {
+                    for (int col = 0; col < cols; col++)
+                    {
+                        const auto values = load_window<3, gradient>(input + col, input_stride, taps);
+                        output[col] = gradient_magnitude<T, decltype(mode)::value>(
+                            dot(values, kernels::sobel_h<gradient>.values, taps), dot(values, kernels::sobel_v<gradient>.values, taps));
+                    }
+                });
+        }
+
+        // Computes the pixels of the full size output rows [first_row, last_row) on the one pixel wide image border
+        template<typename Border, typename T, typename Deleter, typename OutputDeleter>
+        void sobel_border_rows(const array2d<T, Deleter>& input, const Border& border, array2d<T, OutputDeleter>& result, int first_row, int last_row,
+            magnitude_mode magnitude)
+        {
+            using gradient = gradient_type<T>;
+            const auto rows = input.rows();
+            const auto cols = input.cols();
+            const auto top = std::min(1, rows);
+            const auto left = std::min(1, cols);
+
+            for_each_border_span(first_row, last_row, cols, top, std::max(top, rows - 1), left, std::max(left, cols - 1),
+                [&](int row, int first_col, int last_col)
+                {
+                    for (int col = first_col; col < last_col; col++)
+                    {
+                        auto gx = gradient{};
+                        auto gy = gradient{};
+                        for (int r = 0; r < 3; r++)
+                        {
+                            for (int c = 0; c < 3; c++)
+                            {
+                                const auto value = static_cast<gradient>(border_sample(input.data(), input.stride(), rows, cols, row + r - 1, col + c - 1, border));
+                                gx += value * kernels::sobel_h<gradient>.values[r * 3 + c];
+                                gy += value * kernels::sobel_v<gradient>.values[r * 3 + c];
+                            }
+                        }
+                        result.data()[static_cast<std::size_t>(row) * result.stride() + col] = dispatch_magnitude(magnitude, [&](auto mode)
+                            {
+                                return gradient_magnitude<T, decltype(mode)::value>(gx, gy);
+                            });
+                    }
+                });
+        }
+    }
+
+    template<typename ExecutionPolicy, typename T, typename Deleter, typename OutputDeleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    void sobel_into(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, array2d<T, OutputDeleter>& output,
+        magnitude_mode magnitude = magnitude_mode::L2)
+    {
+        static_assert(pixel_traits<T>::is_grayscale(), "Image must be grayscale.");
+        internal::check_magnitude_mode<T>(magnitude);
+
+        internal::check_output_shape(output, input.rows() - 2, input.cols() - 2);
+        execution::for_each_row_band(policy, output.rows(), [&](int first_row, int last_row)
+            {
+                internal::sobel_rows(input, output.data(), output.stride(), first_row, last_row, magnitude);
+            });
+    }
+
+    template<typename T, typename Deleter, typename OutputDeleter>
+    void sobel_into(const array2d<T, Deleter>& input, array2d<T, OutputDeleter>& output, magnitude_mode magnitude = magnitude_mode::L2)
+    {
+        sobel_into(execution::seq, input, output, magnitude);
+    }
+
+    template<typename ExecutionPolicy, typename T, typename Deleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    array2d<T> sobel(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, magnitude_mode magnitude = magnitude_mode::L2)
+    {
+        auto result = array2d<T>(input.rows() - 2, input.cols() - 2);
+        sobel_into(policy, input, result, magnitude);
+        return result;
+    }
+
     template<typename T, typename Deleter>
-    array2d<T> sobel(const array2d<T, Deleter>& input)
+    array2d<T> sobel(const array2d<T, Deleter>& input, magnitude_mode magnitude = magnitude_mode::L2)
+    {
+        return sobel(execution::seq, input, magnitude);
+    }
+
+    // Full size gradient magnitude, only the outermost ring of pixels reads through the border policy
+    template<typename Border, typename ExecutionPolicy, typename T, typename Deleter, typename OutputDeleter,
+        typename = std::enable_if_t<border::is_border_v<Border> && execution::is_execution_policy_v<ExecutionPolicy>>>
+    void sobel_into(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, array2d<T, OutputDeleter>& output, const Border& border = Border{},
+        magnitude_mode magnitude = magnitude_mode::L2)
     {
         static_assert(pixel_traits<T>::is_grayscale(), "Image must be grayscale.");
+        internal::check_magnitude_mode<T>(magnitude);
+
+        internal::check_output_shape(output, input.rows(), input.cols());
+        if (input.rows() > 2 && input.cols() > 2)
+        {
+            execution::for_each_row_band(policy, input.rows() - 2, [&](int first_row, int last_row)
+                {
+                    internal::sobel_rows(input, output.data() + output.stride() + 1, output.stride(), first_row, last_row, magnitude);
+                });
+        }
+
+        execution::for_each_row_band(policy, output.rows(), [&](int first_row, int last_row)
+            {
+                internal::sobel_border_rows(input, border, output, first_row, last_row, magnitude);
+            });
+    }
+
+    template<typename Border, typename T, typename Deleter, typename OutputDeleter,
+        typename = std::enable_if_t<border::is_border_v<Border>>>
+    void sobel_into(const array2d<T, Deleter>& input, array2d<T, OutputDeleter>& output, const Border& border = Border{},
+        magnitude_mode magnitude = magnitude_mode::L2)
+    {
+        sobel_into<Border>(execution::seq, input, output, border, magnitude);
+    }
 
-        auto result = array2d<typename std::remove_const<T>::type>(input.rows() - 2, input.cols() - 2);
-        auto result_iterator = result.begin();
+    template<typename Border, typename ExecutionPolicy, typename T, typename Deleter,
+        typename = std::enable_if_t<border::is_border_v<Border> && execution::is_execution_policy_v<ExecutionPolicy>>>
+    array2d<T> sobel(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, const Border& border = Border{},
+        magnitude_mode magnitude = magnitude_mode::L2)
+    {
+        auto result = array2d<T>(input.rows(), input.cols());
+        sobel_into<Border>(policy, input, result, border, magnitude);
+        return result;
+    }
+
+    template<typename Border, typename T, typename Deleter,
+        typename = std::enable_if_t<border::is_border_v<Border>>>
+    array2d<T> sobel(const array2d<T, Deleter>& input, const Border& border = Border{}, magnitude_mode magnitude = magnitude_mode::L2)
+    {
+        return sobel<Border>(execution::seq, input, border, magnitude);
+    }
+
+    // Angular range of the orientation bins of sobel_gradients
+    enum class orientation_range
+    {
+        Half,   // edge orientation in [0, 180) degrees, opposite gradients share a bin, e.g. for HOG
+        Full    // gradient direction in [0, 360) degrees
+    };
+
+    // Magnitude and quantized orientation of the sobel gradient, orientation holds the bin of every pixel
+    template<typename T>
+    struct oriented_gradients
+    {
+        array2d<T> magnitude;
+        array2d<std::uint8_t> orientation;
+    };
 
-        for (auto& it : lib::make_sliding_window_view<3, 3>(input))
+    // The two sobel gradient components as separate images
+    template<typename G>
+    struct gradient_planes
+    {
+        array2d<G> x;
+        array2d<G> y;
+    };
+
+    namespace internal
+    {
+        // Both sobel gradients of one output row, written out as plain loops that vectorize
+        template<typename T, typename Deleter, typename G>
+        void sobel_gradient_row(const array2d<T, Deleter>& input, int row, G* gx, G* gy)
+        {
+            using gradient = gradient_type<T>;
+            const auto stride = static_cast<std::ptrdiff_t>(input.stride());
+            const auto cols = input.cols() - 2;
+            const auto* top = input.data() + row * stride;
+            const auto* middle = top + stride;
+            const auto* bottom = middle + stride;
+            for (int col = 0; col < cols; col++)
+            {
+                gx[col] = static_cast<G>((gradient(top[col]) - top[col + 2]) + 2 * (gradient(middle[col]) - middle[col + 2]) + (gradient(bottom[col]) - bottom[col + 2]));
+                gy[col] = static_cast<G>((gradient(top[col]) - bottom[col]) + 2 * (gradient(top[col + 1]) - bottom[col + 1]) + (gradient(top[col + 2]) - bottom[col + 2]));
+            }
+        }
+
+        // atan2 within 1e-5 radians from a polynomial of atan on [0, 1]. The octant and half plane are blended in
+        // arithmetically and min / max come from |ax - ay|, GCC turns selects on the same comparison into branches and
+        // the loops over it would not vectorize. Both zeros give 0, the sign follows y like std::atan2.
+        inline float fast_atan2(float y, float x)
         {
-            auto sobel_h_convolution_result = convolve_window_unrolled<3, 3, const array2d<T, Deleter>>(it, kernels::sobel_h<T>);
-            auto sobel_v_convolution_result = convolve_window_unrolled<3, 3, const array2d<T, Deleter>>(it, kernels::sobel_v<T>);
+            constexpr auto pi = static_cast<float>(M_PI);
+            const auto ax = std::abs(x);
+            const auto ay = std::abs(y);
+            const auto difference = std::abs(ax - ay);
+            const auto ratio = (ax + ay - difference) / (ax + ay + difference + std::numeric_limits<float>::min());
+            const auto square = ratio * ratio;
+            const auto polynomial = ((-0.0464964749f * square + 0.15931422f) * square - 0.327622764f) * square * ratio + ratio;
+            const auto octant = polynomial + static_cast<float>(ay > ax) * (pi / 2.f - 2.f * polynomial);
+            const auto half = octant + static_cast<float>(x < 0.f) * (pi - 2.f * octant);
+            return std::copysign(half, y);
+        }
 
-            auto magnitude = sqrt(sobel_h_convolution_result * sobel_h_convolution_result +
-                sobel_v_convolution_result * sobel_v_convolution_result);
+        // Bins of the directions of (gx, gy) among bins equal parts of the range, bin 0 starts at 0 degrees
+        template<typename G>
+        void orientation_bins(const G* gx, const G* gy, std::uint8_t* output, int cols, int bins, orientation_range range)
+        {
+            constexpr auto two_pi = static_cast<float>(2.0 * M_PI);
+            const auto span = range == orientation_range::Full ? two_pi : two_pi / 2.f;
+            const auto scale = static_cast<float>(bins) / span;
+            for (int col = 0; col < cols; col++)
+            {
+                // Directions are in [-pi, pi], a direction of exactly the span wraps around to bin 0
+                const auto angle = fast_atan2(static_cast<float>(gy[col]), static_cast<float>(gx[col]));
+                const auto bin = static_cast<int>((angle + (angle < 0.f ? span : 0.f)) * scale);
+                output[col] = static_cast<std::uint8_t>(bin >= bins ? 0 : bin);
+            }
+        }
+    }
+
+    // Sobel gradient magnitude together with its orientation quantized into bins (at most 256) equal parts of the
+    // range, from one pass over the input. Both outputs are two rows and columns smaller than the input.
+    template<typename ExecutionPolicy, typename T, typename Deleter, typename OutputDeleter, typename OrientationDeleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    void sobel_gradients_into(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, array2d<T, OutputDeleter>& magnitude,
+        array2d<std::uint8_t, OrientationDeleter>& orientation, int bins, orientation_range range = orientation_range::Half,
+        magnitude_mode mode = magnitude_mode::L2)
+    {
+        static_assert(pixel_traits<T>::is_grayscale(), "Image must be grayscale.");
+        internal::check_magnitude_mode<T>(mode);
+        throw_assert(bins > 0 && bins <= 256, "Number of orientation bins must be in [1, 256], but was " << bins << ".")
+
+        internal::check_output_shape(magnitude, input.rows() - 2, input.cols() - 2);
+        internal::check_output_shape(orientation, input.rows() - 2, input.cols() - 2);
+        using gradient = internal::gradient_type<T>;
+        const auto cols = magnitude.cols();
+        execution::for_each_row_band(policy, magnitude.rows(), [&](int first_row, int last_row)
+            {
+                // Row by row, so the gradients of a row are still in the cache when its magnitude and orientation are computed
+                auto gradients = internal::make_band_buffer<gradient>(2, cols);
+                auto* gx = gradients.data();
+                auto* gy = gx + gradients.stride();
+                internal::dispatch_magnitude(mode, [&](auto combine)
+                    {
+                        for (int row = first_row; row < last_row; row++)
+                        {
+                            internal::sobel_gradient_row(input, row, gx, gy);
+                            auto* magnitude_row = magnitude.data() + static_cast<std::size_t>(row) * magnitude.stride();
+                            for (int col = 0; col < cols; col++)
+                                magnitude_row[col] = internal::gradient_magnitude<T, decltype(combine)::value>(gx[col], gy[col]);
+                            internal::orientation_bins(gx, gy, orientation.data() + static_cast<std::size_t>(row) * orientation.stride(), cols, bins, range);
+                        }
+                    });
+            });
+    }
+
+    template<typename T, typename Deleter, typename OutputDeleter, typename OrientationDeleter>
+    void sobel_gradients_into(const array2d<T, Deleter>& input, array2d<T, OutputDeleter>& magnitude, array2d<std::uint8_t, OrientationDeleter>& orientation,
+        int bins, orientation_range range = orientation_range::Half, magnitude_mode mode = magnitude_mode::L2)
+    {
+        sobel_gradients_into(execution::seq, input, magnitude, orientation, bins, range, mode);
+    }
+
+    template<typename ExecutionPolicy, typename T, typename Deleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    oriented_gradients<T> sobel_gradients(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, int bins,
+        orientation_range range = orientation_range::Half, magnitude_mode mode = magnitude_mode::L2)
+    {
+        auto result = oriented_gradients<T>{ array2d<T>(input.rows() - 2, input.cols() - 2), array2d<std::uint8_t>(input.rows() - 2, input.cols() - 2) };
+        sobel_gradients_into(policy, input, result.magnitude, result.orientation, bins, range, mode);
+        return result;
+    }
+
+    template<typename T, typename Deleter>
+    oriented_gradients<T> sobel_gradients(const array2d<T, Deleter>& input, int bins, orientation_range range = orientation_range::Half,
+        magnitude_mode mode = magnitude_mode::L2)
+    {
+        return sobel_gradients(execution::seq, input, bins, range, mode);
+    }
+
+    // The raw gradients gx (sobel_h) and gy (sobel_v), e.g. as int16 for 8-bit input whose gradients stay within +-1020
+    template<typename ExecutionPolicy, typename T, typename Deleter, typename G, typename XDeleter, typename YDeleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    void sobel_gradients_into(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, array2d<G, XDeleter>& x, array2d<G, YDeleter>& y)
+    {
+        static_assert(pixel_traits<T>::is_grayscale(), "Image must be grayscale.");
+        static_assert(std::is_signed_v<G>, "Gradient planes must have a signed type.");
 
+        internal::check_output_shape(x, input.rows() - 2, input.cols() - 2);
+        internal::check_output_shape(y, input.rows() - 2, input.cols() - 2);
+        execution::for_each_row_band(policy, x.rows(), [&](int first_row, int last_row)
+            {
+                for (int row = first_row; row < last_row; row++)
+                    internal::sobel_gradient_row(input, row, x.data() + static_cast<std::size_t>(row) * x.stride(), y.data() + static_cast<std::size_t>(row) * y.stride());
+            });
+    }
+
+    template<typename T, typename Deleter, typename G, typename XDeleter, typename YDeleter>
+    void sobel_gradients_into(const array2d<T, Deleter>& input, array2d<G, XDeleter>& x, array2d<G, YDeleter>& y)
+    {
+        sobel_gradients_into(execution::seq, input, x, y);
+    }
+
+    template<typename G, typename ExecutionPolicy, typename T, typename Deleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    gradient_planes<G> sobel_planes(const ExecutionPolicy& policy, const array2d<T, Deleter>& input)
+    {
+        auto result = gradient_planes<G>{ array2d<G>(input.rows() - 2, input.cols() - 2), array2d<G>(input.rows() - 2, input.cols() - 2) };
+        sobel_gradients_into(policy, input, result.x, result.y);
+        return result;
+    }
+
+    template<typename G, typename T, typename Deleter>
+    gradient_planes<G> sobel_planes(const array2d<T, Deleter>& input)
+    {
+        return sobel_planes<G>(execution::seq, input);
+    }
+
+    namespace internal
+    {
+        // Computes the output rows [first_row, last_row) of the roberts cross magnitude
+        template<typename T, typename Deleter>
+        void roberts_rows(const array2d<T, Deleter>& input, T* output, std::ptrdiff_t output_stride, int first_row, int last_row, magnitude_mode magnitude)
+        {
+            const auto stride = static_cast<std::ptrdiff_t>(input.stride());
+            const auto cols = input.cols() - 1;
+            if constexpr (simd::is_vectorized_v<T>)
+            {
+                if (auto function = simd::roberts_kernel<T>(); function && has_vector_magnitude<T>(magnitude))
+                {
+                    function(input.data() + first_row * stride, stride, output + first_row * output_stride, output_stride, last_row - first_row, cols, magnitude);
+                    return;
+                }
+            }
+
+            using gradient = gradient_type<T>;
+            constexpr auto taps = std::make_index_sequence<4>{};
+            dispatch_magnitude(magnitude, [&](auto mode)
+                {
+                    for (int row = first_row; row < last_row; row++)
+                    {
+                        const auto* input_row = input.data() + row * stride;
+                        auto* output_row = output + row * output_stride;
+                        for (int col = 0; col < cols; col++)
+                        {
+                            const auto values = load_window<2, gradient>(input_row + col, stride, taps);
+                            output_row[col] = gradient_magnitude<T, decltype(mode)::value>(
+                                dot(values, kernels::roberts_h<gradient>.values, taps), dot(values, kernels::roberts_v<gradient>.values, taps));
+                        }
+                    }
+                });
+        }
+    }
+
+    // Gradient magnitude from the two diagonal differences of every 2x2 window, about a quarter of the work of sobel
+    // and without its smoothing. The result is one row and column smaller than the input, output pixel (r, c) belongs
+    // to the window whose top left pixel is input pixel (r, c).
+    template<typename ExecutionPolicy, typename T, typename Deleter, typename OutputDeleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    void roberts_into(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, array2d<T, OutputDeleter>& output,
+        magnitude_mode magnitude = magnitude_mode::L2)
+    {
+        static_assert(pixel_traits<T>::is_grayscale(), "Image must be grayscale.");
+        internal::check_magnitude_mode<T>(magnitude);
+
+        internal::check_output_shape(output, input.rows() - 1, input.cols() - 1);
+        execution::for_each_row_band(policy, output.rows(), [&](int first_row, int last_row)
+            {
+                internal::roberts_rows(input, output.data(), output.stride(), first_row, last_row, magnitude);
+            });
+    }
+
+    template<typename T, typename Deleter, typename OutputDeleter>
+    void roberts_into(const array2d<T, Deleter>& input, array2d<T, OutputDeleter>& output, magnitude_mode magnitude = magnitude_mode::L2)
+    {
+        roberts_into(execution::seq, input, output, magnitude);
+    }
+
+    template<typename ExecutionPolicy, typename T, typename Deleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    array2d<T> roberts(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, magnitude_mode magnitude = magnitude_mode::L2)
+    {
+        auto result = array2d<T>(input.rows() - 1, input.cols() - 1);
+        roberts_into(policy, input, result, magnitude);
+        return result;
+    }
+
+    template<typename T, typename Deleter>
+    array2d<T> roberts(const array2d<T, Deleter>& input, magnitude_mode magnitude = magnitude_mode::L2)
+    {
+        return roberts(execution::seq, input, magnitude);
+    }
+
+    // Gradient magnitude of a color image, equal to sobel(convert<TGray, Mode>(input)) without materializing the grayscale
+    // image: every band converts its input rows into a three row ring buffer right before the gradient reads them.
+    // Every ring row is also written to a mirror slot three rows further down, so the three rows of a window are always
+    // consecutive in memory and the vectorized sobel kernels can read them with a single stride.
+    template<grayscale_mode Mode = grayscale_mode::Luminosity, typename ExecutionPolicy, typename TFrom, typename Deleter, typename TGray, typename OutputDeleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    void grayscale_sobel_into(const ExecutionPolicy& policy, const array2d<TFrom, Deleter>& input, array2d<TGray, OutputDeleter>& output,
+        magnitude_mode magnitude = magnitude_mode::L2)
+    {
+        static_assert(pixel_traits<TFrom>::is_rgb(), "Image must be a color image.");
+        static_assert(pixel_traits<TGray>::is_grayscale(), "Output must be grayscale.");
+        internal::check_magnitude_mode<TGray>(magnitude);
+
+        internal::check_output_shape(output, input.rows() - 2, input.cols() - 2);
+        const auto cols = static_cast<std::size_t>(input.cols());
+        execution::for_each_row_band(policy, output.rows(), [&](int first_row, int last_row)
+            {
+                auto ring_rows = internal::make_band_buffer<TGray>(5, input.cols());
+                auto* ring = ring_rows.data();
+                const auto convert_row = [&](int row)
+                {
+                    const auto slot = static_cast<std::size_t>(row % 3);
+                    const auto* source = input.data() + static_cast<std::size_t>(row) * input.stride();
+                    auto* target = ring + slot * cols;
+                    for (std::size_t col = 0; col < cols; col++)
+                        target[col] = internal::convert<TGray, Mode, TFrom>(source[col]);
+                    if (slot + 3 < 5)
+                        std::copy_n(target, cols, ring + (slot + 3) * cols);
+                };
+
+                convert_row(first_row);
+                convert_row(first_row + 1);
+                for (int row = first_row; row < last_row; row++)
+                {
+                    convert_row(row + 2);
+                    internal::sobel_row(ring + static_cast<std::size_t>(row % 3) * cols, static_cast<std::ptrdiff_t>(cols),
+                        output.data() + static_cast<std::size_t>(row) * output.stride(), output.cols(), magnitude);
+                }
+            });
+    }
+
+    template<grayscale_mode Mode = grayscale_mode::Luminosity, typename TFrom, typename Deleter, typename TGray, typename OutputDeleter>
+    void grayscale_sobel_into(const array2d<TFrom, Deleter>& input, array2d<TGray, OutputDeleter>& output, magnitude_mode magnitude = magnitude_mode::L2)
+    {
+        grayscale_sobel_into<Mode>(execution::seq, input, output, magnitude);
+    }
+
+    template<typename TGray, grayscale_mode Mode = grayscale_mode::Luminosity, typename ExecutionPolicy, typename TFrom, typename Deleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    array2d<TGray> grayscale_sobel(const ExecutionPolicy& policy, const array2d<TFrom, Deleter>& input, magnitude_mode magnitude = magnitude_mode::L2)
+    {
+        auto result = array2d<TGray>(input.rows() - 2, input.cols() - 2);
+        grayscale_sobel_into<Mode>(policy, input, result, magnitude);
+        return result;
+    }
+
+    template<typename TGray, grayscale_mode Mode = grayscale_mode::Luminosity, typename TFrom, typename Deleter>
+    array2d<TGray> grayscale_sobel(const array2d<TFrom, Deleter>& input, magnitude_mode magnitude = magnitude_mode::L2)
+    {
+        return grayscale_sobel<TGray, Mode>(execution::seq, input, magnitude);
+    }
+
+    namespace internal
+    {
+        // Strongest response of a bank of eight 3x3 kernels for the output rows [first_row, last_row). Every window is
+        // loaded once for all kernels and the running maximum and its kernel index are kept branch free, so the column
+        // loop vectorizes. store(row, col, response, direction) receives the winner, the first kernel wins a tie.
+        template<typename T, typename Deleter, typename K, typename F>
+        void compass_rows(const array2d<T, Deleter>& input, const std::array<kernel<3, 3, K>, 8>& kernels, int first_row, int last_row, F&& store)
+        {
+            constexpr auto taps = std::make_index_sequence<9>{};
+            const auto stride = static_cast<std::ptrdiff_t>(input.stride());
+            const auto cols = input.cols() - 2;
+            for (int row = first_row; row < last_row; row++)
+            {
+                const auto* input_row = input.data() + row * stride;
+                for (int col = 0; col < cols; col++)
+                {
+                    const auto values = load_window<3, K>(input_row + col, stride, taps);
+                    auto best = dot(values, kernels[0].values, taps);
+                    auto direction = std::uint8_t{ 0 };
+                    for (std::uint8_t k = 1; k < 8; k++)
+                    {
+                        const auto response = dot(values, kernels[k].values, taps);
+                        direction = response > best ? k : direction;
+                        best = std::max(best, response);
+                    }
+                    store(row, col, best, direction);
+                }
+            }
+        }
+
+        // Clamps a compass response to the pixel range, [0, 1] for floating point images
+        template<typename T, typename K>
+        T compass_response(K response)
+        {
             if constexpr (std::is_floating_point_v<T>)
-                * result_iterator = std::clamp(magnitude, T{ 0 }, T{ 1 });
+                return static_cast<T>(std::clamp(response, K{ 0 }, K{ 1 }));
             else
-                *result_iterator = std::clamp(magnitude, T{ 0 }, std::numeric_limits<T>::max());
-
-            result_iterator++;
+                return static_cast<T>(std::clamp(response, K{ 0 }, static_cast<K>(std::numeric_limits<T>::max())));
         }
+    }
+
+    // Edge strength as the strongest response of a compass bank of eight rotated kernels, e.g. kernels::kirsch_compass
+    // or kernels::prewitt_compass, without an intermediate image per direction. directions receives the index of the
+    // strongest kernel, i.e. the edge orientation in steps of 45 degrees. Integral images need a signed kernel type.
+    template<typename ExecutionPolicy, typename T, typename Deleter, typename K, typename OutputDeleter, typename DirectionDeleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    void compass_edges_into(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, const std::array<kernel<3, 3, K>, 8>& kernels,
+        array2d<T, OutputDeleter>& output, array2d<std::uint8_t, DirectionDeleter>& directions)
+    {
+        static_assert(pixel_traits<T>::is_grayscale(), "Image must be grayscale.");
+        static_assert(std::is_signed_v<K>, "Compass kernels must have a signed value type.");
+
+        internal::check_output_shape(output, input.rows() - 2, input.cols() - 2);
+        internal::check_output_shape(directions, input.rows() - 2, input.cols() - 2);
+        const auto stride = static_cast<std::size_t>(output.stride());
+        const auto direction_stride = static_cast<std::size_t>(directions.stride());
+        execution::for_each_row_band(policy, output.rows(), [&](int first_row, int last_row)
+            {
+                internal::compass_rows(input, kernels, first_row, last_row, [&](int row, int col, K response, std::uint8_t direction)
+                    {
+                        output.data()[row * stride + col] = internal::compass_response<T>(response);
+                        directions.data()[row * direction_stride + col] = direction;
+                    });
+            });
+    }
+
+    template<typename ExecutionPolicy, typename T, typename Deleter, typename K, typename OutputDeleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    void compass_edges_into(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, const std::array<kernel<3, 3, K>, 8>& kernels,
+        array2d<T, OutputDeleter>& output)
+    {
+        static_assert(pixel_traits<T>::is_grayscale(), "Image must be grayscale.");
+        static_assert(std::is_signed_v<K>, "Compass kernels must have a signed value type.");
+
+        internal::check_output_shape(output, input.rows() - 2, input.cols() - 2);
+        const auto stride = static_cast<std::size_t>(output.stride());
+        execution::for_each_row_band(policy, output.rows(), [&](int first_row, int last_row)
+            {
+                internal::compass_rows(input, kernels, first_row, last_row, [&](int row, int col, K response, std::uint8_t)
+                    {
+                        output.data()[row * stride + col] = internal::compass_response<T>(response);
+                    });
+            });
+    }
+
+    template<typename T, typename Deleter, typename K, typename OutputDeleter, typename DirectionDeleter>
+    void compass_edges_into(const array2d<T, Deleter>& input, const std::array<kernel<3, 3, K>, 8>& kernels,
+        array2d<T, OutputDeleter>& output, array2d<std::uint8_t, DirectionDeleter>& directions)
+    {
+        compass_edges_into(execution::seq, input, kernels, output, directions);
+    }
+
+    template<typename T, typename Deleter, typename K, typename OutputDeleter>
+    void compass_edges_into(const array2d<T, Deleter>& input, const std::array<kernel<3, 3, K>, 8>& kernels, array2d<T, OutputDeleter>& output)
+    {
+        compass_edges_into(execution::seq, input, kernels, output);
+    }
+
+    template<typename ExecutionPolicy, typename T, typename Deleter, typename K,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    array2d<T> compass_edges(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, const std::array<kernel<3, 3, K>, 8>& kernels)
+    {
+        auto result = array2d<T>(input.rows() - 2, input.cols() - 2);
+        compass_edges_into(policy, input, kernels, result);
         return result;
     }
+
+    template<typename T, typename Deleter, typename K>
+    array2d<T> compass_edges(const array2d<T, Deleter>& input, const std::array<kernel<3, 3, K>, 8>& kernels)
+    {
+        return compass_edges(execution::seq, input, kernels);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,274 @@
+#pragma once
+#include <core/core.h>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <vector>
+#include "dft.h"
+#include "kernel.h"
+#include "simd.h"
+
+namespace lib
+{
+    namespace internal
+    {
+        // FFT size along one axis: large enough that a tile is several kernel sizes wide, so the zero padding of
+        // every tile stays a small fraction of it, but no larger than needed for the whole image
+        inline std::size_t fft_tile_size(int image_size, int kernel_size)
+        {
+            const auto padding = static_cast<std::size_t>(kernel_size - 1);
+            const auto preferred = next_power_of_two(std::max<std::size_t>(4 * padding, 64));
+            return std::max<std::size_t>(2, std::min(preferred, next_power_of_two(static_cast<std::size_t>(image_size) + padding)));
+        }
+
+        template<typename T>
+        struct fft_workspace
+        {
+            std::vector<T> tile;
+            std::vector<std::complex<T>> spectrum;
+            std::vector<std::complex<T>> transposed;
+        };
+
+        template<typename T>
+        void transpose(const T* input, std::size_t rows, std::size_t cols, T* output)
+        {
+            for (std::size_t r = 0; r < rows; r++)
+                for (std::size_t c = 0; c < cols; c++)
+                    output[c * rows + r] = input[r * cols + c];
+        }
+
+        // Overlap-add convolution with one kernel spectrum, the input is split into tiles whose full convolution
+        // fits into an fft_rows x fft_cols transform without circular wrap around. Both passes of the 2D transform
+        // run over all columns at once, the spectrum is stored transposed as fft_cols x (fft_rows / 2 + 1).
+        template<typename T>
+        class fft_convolver
+        {
+            std::size_t fft_rows_;
+            std::size_t fft_cols_;
+            int kernel_rows_;
+            int kernel_cols_;
+            real_fft_plan<T> column_plan_;
+            fft_plan<T> row_plan_;
+            std::vector<std::complex<T>> kernel_spectrum_;
+
+            void forward(const T* input, fft_workspace<T>& workspace, std::complex<T>* spectrum) const
+            {
+                column_plan_.forward(input, workspace.transposed.data(), fft_cols_);
+                transpose(workspace.transposed.data(), column_plan_.bins(), fft_cols_, spectrum);
+                row_plan_.forward(spectrum, column_plan_.bins());
+            }
+
+            void inverse(fft_workspace<T>& workspace) const
+            {
+                row_plan_.inverse(workspace.spectrum.data(), column_plan_.bins());
+                transpose(workspace.spectrum.data(), fft_cols_, column_plan_.bins(), workspace.transposed.data());
+                column_plan_.inverse(workspace.transposed.data(), workspace.tile.data(), fft_cols_);
+            }
+
+        public:
+            fft_convolver(const T* kernel, int kernel_rows, int kernel_cols, std::size_t fft_rows, std::size_t fft_cols) :
+                fft_rows_(fft_rows),
+                fft_cols_(fft_cols),
+                kernel_rows_(kernel_rows),
+                kernel_cols_(kernel_cols),
+                column_plan_(fft_rows),
+                row_plan_(fft_cols)
+            {
+                // lib::convolve correlates, the transform convolves, so the kernel is flipped in both directions
+                auto workspace = make_workspace();
+                std::fill(workspace.tile.begin(), workspace.tile.end(), T{ 0 });
+                for (int r = 0; r < kernel_rows; r++)
+                    for (int c = 0; c < kernel_cols; c++)
+                        workspace.tile[r * fft_cols + c] = kernel[(kernel_rows - 1 - r) * kernel_cols + (kernel_cols - 1 - c)];
+
+                kernel_spectrum_.resize(workspace.spectrum.size());
+                forward(workspace.tile.data(), workspace, kernel_spectrum_.data());
+            }
+
+            int tile_rows() const
+            {
+                return static_cast<int>(fft_rows_) - (kernel_rows_ - 1);
+            }
+
+            int tile_cols() const
+            {
+                return static_cast<int>(fft_cols_) - (kernel_cols_ - 1);
+            }
+
+            fft_workspace<T> make_workspace() const
+            {
+                return fft_workspace<T>{
+                    std::vector<T>(fft_rows_ * fft_cols_),
+                    std::vector<std::complex<T>>(fft_cols_ * column_plan_.bins()),
+                    std::vector<std::complex<T>>(fft_cols_ * column_plan_.bins())
+                };
+            }
+
+            // Adds the convolution of the input tile starting at (first_row, first_col) to the valid region output,
+            // which has to be zero initialized. Tiles of one tile row only overlap tiles of the neighbouring tile rows.
+            void accumulate_tile(const T* input, std::ptrdiff_t input_stride, int input_rows, int input_cols, int first_row, int first_col,
+                T* output, std::ptrdiff_t output_stride, fft_workspace<T>& workspace) const
+            {
+                const auto rows = std::min(tile_rows(), input_rows - first_row);
+                const auto cols = std::min(tile_cols(), input_cols - first_col);
+
+                std::fill(workspace.tile.begin(), workspace.tile.end(), T{ 0 });
+                for (int r = 0; r < rows; r++)
+                    std::copy_n(input + static_cast<std::size_t>(first_row + r) * input_stride + first_col, cols, workspace.tile.data() + r * fft_cols_);
+
+                forward(workspace.tile.data(), workspace, workspace.spectrum.data());
+                for (std::size_t i = 0; i < workspace.spectrum.size(); i++)
+                    workspace.spectrum[i] = multiply(workspace.spectrum[i], kernel_spectrum_[i]);
+                inverse(workspace);
+
+                // Full convolution pixel (y, x) of the tile is valid output pixel (y - (kernel_rows - 1), x - (kernel_cols - 1))
+                const auto output_rows = input_rows - (kernel_rows_ - 1);
+                const auto output_cols = input_cols - (kernel_cols_ - 1);
+                const auto first_y = std::max(0, kernel_rows_ - 1 - first_row);
+                const auto last_y = std::min(rows + kernel_rows_ - 1, output_rows + kernel_rows_ - 1 - first_row);
+                const auto first_x = std::max(0, kernel_cols_ - 1 - first_col);
+                const auto last_x = std::min(cols + kernel_cols_ - 1, output_cols + kernel_cols_ - 1 - first_col);
+                for (int y = first_y; y < last_y; y++)
+                {
+                    const auto* source = workspace.tile.data() + y * fft_cols_;
+                    auto* target = output + (first_row + y - (kernel_rows_ - 1)) * output_stride + (first_col - (kernel_cols_ - 1));
+                    for (int x = first_x; x < last_x; x++)
+                        target[x] += source[x];
+                }
+            }
+        };
+
+        // A parallel policy distributes tile rows instead of image rows, so it must not bundle them into bands of 16
+        template<typename ExecutionPolicy>
+        ExecutionPolicy tile_row_policy(const ExecutionPolicy& policy)
+        {
+            if constexpr (std::is_same_v<ExecutionPolicy, execution::parallel_policy>)
+                return policy.with_grain(1);
+            else
+                return policy;
+        }
+
+        template<typename ExecutionPolicy, typename T, typename Deleter>
+        void fft_convolve(const ExecutionPolicy& policy, const T* input, std::ptrdiff_t input_stride, int rows, int cols, const T* kernel, int kernel_rows, int kernel_cols,
+            array2d<T, Deleter>& result)
+        {
+            const auto convolver = fft_convolver<T>(kernel, kernel_rows, kernel_cols, fft_tile_size(rows, kernel_rows), fft_tile_size(cols, kernel_cols));
+            const auto tile_rows = (rows + convolver.tile_rows() - 1) / convolver.tile_rows();
+            const auto tile_cols = (cols + convolver.tile_cols() - 1) / convolver.tile_cols();
+
+            // A tile row spans tile_rows() + kernel_rows - 1 <= 2 * tile_rows() output rows, so all even and then all odd
+            // tile rows can be processed concurrently
+            std::fill(result.begin(), result.end(), T{ 0 });
+            for (int phase = 0; phase < 2; phase++)
+            {
+                execution::for_each_row_band(tile_row_policy(policy), (tile_rows + 1 - phase) / 2, [&](int first, int last)
+                    {
+                        auto workspace = convolver.make_workspace();
+                        for (int i = first; i < last; i++)
+                        {
+                            for (int tile_col = 0; tile_col < tile_cols; tile_col++)
+                                convolver.accumulate_tile(input, input_stride, rows, cols, (2 * i + phase) * convolver.tile_rows(), tile_col * convolver.tile_cols(),
+                                    result.data(), result.stride(), workspace);
+                        }
+                    });
+            }
+        }
+
+        // Elements per multiply-add of the direct path, which runs the vectorized kernels for float
+        template<typename T>
+        int direct_lanes()
+        {
+            if constexpr (simd::is_vectorized_v<T>)
+            {
+                switch (simd::active_level())
+                {
+                case simd_level::SSE41: return static_cast<int>(16 / sizeof(T));
+                case simd_level::AVX2: return static_cast<int>(32 / sizeof(T));
+                case simd_level::AVX512: return static_cast<int>(64 / sizeof(T));
+                default: return 1;
+                }
+            }
+            return 1;
+        }
+
+        // Cost of one point of an FFT pass relative to one direct multiply-add, fitted to bench/convolve_bench
+        constexpr double fft_cost_per_point = 1.0;
+
+        // Operation count model of the direct and the FFT path, both per output pixel
+        template<typename T>
+        bool prefer_fft(int rows, int cols, int kernel_rows, int kernel_cols)
+        {
+            if constexpr (!std::is_floating_point_v<T>)
+            {
+                return false;
+            }
+            else
+            {
+                if (rows < kernel_rows || cols < kernel_cols)
+                    return false;
+
+                const auto fft_rows = static_cast<double>(fft_tile_size(rows, kernel_rows));
+                const auto fft_cols = static_cast<double>(fft_tile_size(cols, kernel_cols));
+                const auto tile_area = (fft_rows - (kernel_rows - 1)) * (fft_cols - (kernel_cols - 1));
+
+                const auto direct_cost = static_cast<double>(kernel_rows) * kernel_cols / direct_lanes<T>();
+                const auto fft_cost = fft_cost_per_point * fft_rows * fft_cols * std::log2(fft_rows * fft_cols) / tile_area;
+                return fft_cost < direct_cost;
+            }
+        }
+    }
+
+    // Valid region correlation like convolve, computed in O(log(kernel size)) per pixel in the frequency domain. Unlike
+    // the direct path this still allocates its transform plans and per band workspaces.
+    template<typename ExecutionPolicy, typename T, typename Deleter, typename OutputDeleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    void fft_convolve_into(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, const dynamic_kernel<T>& convolution_kernel,
+        array2d<T, OutputDeleter>& output)
+    {
+        static_assert(std::is_floating_point_v<T>, "FFT convolution needs a floating point image.");
+
+        internal::check_output_shape(output, input.rows() - (convolution_kernel.height - 1), input.cols() - (convolution_kernel.width - 1));
+        internal::fft_convolve(policy, input.data(), input.stride(), input.rows(), input.cols(), convolution_kernel.values.data(), convolution_kernel.height, convolution_kernel.width, output);
+    }
+
+    template<typename ExecutionPolicy, std::size_t Height, std::size_t Width, typename T, typename Deleter, typename OutputDeleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    void fft_convolve_into(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, const kernel<Height, Width, T>& convolution_kernel,
+        array2d<T, OutputDeleter>& output)
+    {
+        static_assert(std::is_floating_point_v<T>, "FFT convolution needs a floating point image.");
+
+        internal::check_output_shape(output, input.rows() - static_cast<int>(Height - 1), input.cols() - static_cast<int>(Width - 1));
+        internal::fft_convolve(policy, input.data(), input.stride(), input.rows(), input.cols(), convolution_kernel.values.data(), static_cast<int>(Height), static_cast<int>(Width), output);
+    }
+
+    template<typename T, typename Deleter, typename Kernel, typename OutputDeleter>
+    void fft_convolve_into(const array2d<T, Deleter>& input, const Kernel& convolution_kernel, array2d<T, OutputDeleter>& output)
+    {
+        fft_convolve_into(execution::seq, input, convolution_kernel, output);
+    }
+
+    template<typename ExecutionPolicy, typename T, typename Deleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    array2d<T> fft_convolve(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, const dynamic_kernel<T>& convolution_kernel)
+    {
+        auto result = array2d<T>(input.rows() - (convolution_kernel.height - 1), input.cols() - (convolution_kernel.width - 1));
+        fft_convolve_into(policy, input, convolution_kernel, result);
+        return result;
+    }
+
+    template<typename ExecutionPolicy, std::size_t Height, std::size_t Width, typename T, typename Deleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    array2d<T> fft_convolve(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, const kernel<Height, Width, T>& convolution_kernel)
+    {
+        auto result = array2d<T>(input.rows() - static_cast<int>(Height - 1), input.cols() - static_cast<int>(Width - 1));
+        fft_convolve_into(policy, input, convolution_kernel, result);
+        return result;
+    }
+
+    template<typename T, typename Deleter, typename Kernel>
+    array2d<T> fft_convolve(const array2d<T, Deleter>& input, const Kernel& convolution_kernel)
+    {
+        return fft_convolve(execution::seq, input, convolution_kernel);
+    }
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include <core/core.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include "kernel.h"
+#include "simd.h"
+
+namespace lib
+{
+    namespace internal
+    {
+        // Range of every partial sum of a fixed point correlation of 8-bit pixels with Kernel, rounding included.
+        // Pixels are never negative, so each partial sum lies between the sums of the negative and the positive terms.
+        template<const auto& Kernel, int Shift>
+        struct fixed_point_bounds
+        {
+            static constexpr long long rounding = Shift > 0 ? 1LL << (Shift - 1) : 0;
+
+            static constexpr long long lowest()
+            {
+                auto sum = rounding;
+                for (const auto& coefficient : Kernel.values)
+                    sum += coefficient < 0 ? static_cast<long long>(coefficient) * 255 : 0;
+                return sum;
+            }
+
+            static constexpr long long highest()
+            {
+                auto sum = rounding;
+                for (const auto& coefficient : Kernel.values)
+                    sum += coefficient > 0 ? static_cast<long long>(coefficient) * 255 : 0;
+                return sum;
+            }
+
+            template<typename T>
+            static constexpr bool fits()
+            {
+                return lowest() >= std::numeric_limits<T>::lowest() && highest() <= std::numeric_limits<T>::max();
+            }
+        };
+
+        // int16 whenever the kernel allows it, which doubles the lanes per vector compared to int32
+        template<const auto& Kernel, int Shift>
+        using fixed_point_accumulator = std::conditional_t<fixed_point_bounds<Kernel, Shift>::template fits<std::int16_t>(), std::int16_t, std::int32_t>;
+
+        template<typename Accumulator, int Shift, std::size_t Height, std::size_t Width, typename TOut, typename Deleter, typename OutputDeleter>
+        void fixed_convolve_rows(const array2d<std::uint8_t, Deleter>& input, const std::array<Accumulator, Height* Width>& coefficients,
+            array2d<TOut, OutputDeleter>& result, int first_row, int last_row)
+        {
+            constexpr auto rounding = static_cast<Accumulator>(Shift > 0 ? 1 << (Shift - 1) : 0);
+            for (int row = first_row; row < last_row; row++)
+            {
+                auto* output_row = result.data() + static_cast<std::size_t>(row) * result.stride();
+                for (int col = 0; col < result.cols(); col++)
+                {
+                    auto accumulator = rounding;
+                    for (std::size_t r = 0; r < Height; r++)
+                    {
+                        const auto* input_row = input.data() + static_cast<std::size_t>(row + r) * input.stride() + col;
+                        for (std::size_t c = 0; c < Width; c++)
+                            accumulator = static_cast<Accumulator>(accumulator + input_row[c] * coefficients[r * Width + c]);
+                    }
+                    output_row[col] = static_cast<TOut>(std::clamp<std::int32_t>(accumulator >> Shift, std::numeric_limits<TOut>::lowest(), std::numeric_limits<TOut>::max()));
+                }
+            }
+        }
+    }
+
+    // Correlates an 8-bit image with an integral compile time kernel without leaving integer arithmetic: every output
+    // is (sum + 2^(Shift - 1)) >> Shift saturated to TOut, e.g. convolve_fixed<kernels::gaussian_blur<int>, 4> blurs
+    // to uint8_t and convolve_fixed<kernels::sobel_h<int>, 0, std::int16_t> keeps the sign of a gradient.
+    // Sums are accumulated in int16 when the kernel's coefficient bounds allow it and in int32 otherwise.
+    // The output type is taken from the output array.
+    template<const auto& Kernel, int Shift = 0, typename ExecutionPolicy, typename Deleter, typename TOut, typename OutputDeleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    void convolve_fixed_into(const ExecutionPolicy& policy, const array2d<std::uint8_t, Deleter>& input, array2d<TOut, OutputDeleter>& output)
+    {
+        using traits = kernel_traits<std::remove_cv_t<std::remove_reference_t<decltype(Kernel)>>>;
+        using accumulator = internal::fixed_point_accumulator<Kernel, Shift>;
+        constexpr auto height = traits::height;
+        constexpr auto width = traits::width;
+
+        static_assert(std::is_integral_v<typename traits::value_type>, "Fixed point convolution needs an integral kernel.");
+        static_assert(std::is_same_v<TOut, std::uint8_t> || std::is_same_v<TOut, std::int16_t>, "Output must be uint8_t or int16_t.");
+        static_assert(Shift >= 0 && Shift < 8 * static_cast<int>(sizeof(accumulator)) - 1, "Shift exceeds the accumulator.");
+        static_assert(internal::fixed_point_bounds<Kernel, Shift>::template fits<std::int32_t>(), "Kernel sums can overflow int32.");
+
+        constexpr auto coefficients = []
+        {
+            auto output = std::array<accumulator, height * width>();
+            for (std::size_t i = 0; i < height * width; i++)
+                output[i] = static_cast<accumulator>(Kernel.values[i]);
+            return output;
+        }();
+
+        internal::check_output_shape(output, input.rows() - static_cast<int>(height - 1), input.cols() - static_cast<int>(width - 1));
+        execution::for_each_row_band(policy, output.rows(), [&](int first_row, int last_row)
+            {
+                if constexpr (std::is_same_v<accumulator, std::int16_t>)
+                {
+                    if (auto function = simd::fixed_convolve_kernel<TOut>())
+                    {
+                        function(input.data() + static_cast<std::size_t>(first_row) * input.stride(), input.stride(),
+                            output.data() + static_cast<std::size_t>(first_row) * output.stride(), output.stride(),
+                            last_row - first_row, output.cols(), coefficients.data(), static_cast<int>(height), static_cast<int>(width), Shift);
+                        return;
+                    }
+                }
+                internal::fixed_convolve_rows<accumulator, Shift, height, width>(input, coefficients, output, first_row, last_row);
+            });
+    }
+
+    template<const auto& Kernel, int Shift = 0, typename Deleter, typename TOut, typename OutputDeleter>
+    void convolve_fixed_into(const array2d<std::uint8_t, Deleter>& input, array2d<TOut, OutputDeleter>& output)
+    {
+        convolve_fixed_into<Kernel, Shift>(execution::seq, input, output);
+    }
+
+    template<const auto& Kernel, int Shift = 0, typename TOut = std::uint8_t, typename ExecutionPolicy, typename Deleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    array2d<TOut> convolve_fixed(const ExecutionPolicy& policy, const array2d<std::uint8_t, Deleter>& input)
+    {
+        using traits = kernel_traits<std::remove_cv_t<std::remove_reference_t<decltype(Kernel)>>>;
+        auto result = array2d<TOut>(input.rows() - static_cast<int>(traits::height - 1), input.cols() - static_cast<int>(traits::width - 1));
+        convolve_fixed_into<Kernel, Shift>(policy, input, result);
+        return result;
+    }
+
+    template<const auto& Kernel, int Shift = 0, typename TOut = std::uint8_t, typename Deleter>
+    array2d<TOut> convolve_fixed(const array2d<std::uint8_t, Deleter>& input)
+    {
+        return convolve_fixed<Kernel, Shift, TOut>(execution::seq, input);
+    }
+}
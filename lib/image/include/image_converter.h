@@ -116,19 +116,44 @@ namespace lib {
     }
 
 
-    template<typename TTo, grayscale_mode mode = grayscale_mode::None, typename TFrom, typename Deleter>
-    array2d<TTo> convert(const array2d<TFrom, Deleter>& input)
+    // The target pixel type is taken from the output array, which must have the size of the input
+    template<grayscale_mode mode = grayscale_mode::None, typename ExecutionPolicy, typename TFrom, typename Deleter, typename TTo, typename OutputDeleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    void convert_into(const ExecutionPolicy& policy, const array2d<TFrom, Deleter>& input, array2d<TTo, OutputDeleter>& output)
     {
-        auto output = array2d<TTo>(input.rows(), input.cols());
+        internal::check_output_shape(output, input.rows(), input.cols());
 
-        array2d<TFrom>::const_iterator in;
-        array2d<TTo>::iterator out;
-        for (in = input.cbegin(), out = output.begin();
-            in < input.cend(), out < output.end();
-            in++, out++)
-        {
-            *out = internal::convert<TTo, mode, TFrom>(*in);
-        }
+        execution::for_each_row_band(policy, input.rows(), [&](int first_row, int last_row)
+            {
+                typename array2d<TFrom, Deleter>::const_iterator in;
+                typename array2d<TTo, OutputDeleter>::iterator out;
+                for (in = input.cbegin() + static_cast<std::ptrdiff_t>(first_row) * input.cols(), out = output.begin() + static_cast<std::ptrdiff_t>(first_row) * output.cols();
+                    in < input.cbegin() + static_cast<std::ptrdiff_t>(last_row) * input.cols();
+                    in++, out++)
+                {
+                    *out = internal::convert<TTo, mode, TFrom>(*in);
+                }
+            });
+    }
+
+    template<grayscale_mode mode = grayscale_mode::None, typename TFrom, typename Deleter, typename TTo, typename OutputDeleter>
+    void convert_into(const array2d<TFrom, Deleter>& input, array2d<TTo, OutputDeleter>& output)
+    {
+        convert_into<mode>(execution::seq, input, output);
+    }
+
+    template<typename TTo, grayscale_mode mode = grayscale_mode::None, typename ExecutionPolicy, typename TFrom, typename Deleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    array2d<TTo> convert(const ExecutionPolicy& policy, const array2d<TFrom, Deleter>& input)
+    {
+        auto output = array2d<TTo>(input.rows(), input.cols());
+        convert_into<mode>(policy, input, output);
         return output;
     }
-}
+
+    template<typename TTo, grayscale_mode mode = grayscale_mode::None, typename TFrom, typename Deleter>
+    array2d<TTo> convert(const array2d<TFrom, Deleter>& input)
+    {
+        return convert<TTo, mode>(execution::seq, input);
+    }
+}
\ No newline at end of file
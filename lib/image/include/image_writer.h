@@ -1,12 +1,22 @@
 #pragma once
+#include <algorithm>
 #include <string>
 #include "pixel.h"
 
 namespace lib {
     template<typename T, typename Deleter>
-    void write_image(const std::string& path, array2d<T, Deleter>& image)
+    void write_image(const std::string& path, const array2d<T, Deleter>& image)
     {
         static_assert(pixel_traits<T>::channel_size() == 1);
-        stbi_write_jpg(path.c_str(), image.cols(), image.rows(), pixel_traits<T>::channels(), image.data(), 90);
+        if (image.is_contiguous())
+        {
+            stbi_write_jpg(path.c_str(), image.cols(), image.rows(), pixel_traits<T>::channels(), image.data(), 90);
+            return;
+        }
+
+        // stb writes jpgs from densely packed rows only
+        auto packed = array2d<T>(image.rows(), image.cols());
+        std::copy(image.begin(), image.end(), packed.begin());
+        stbi_write_jpg(path.c_str(), packed.cols(), packed.rows(), pixel_traits<T>::channels(), packed.data(), 90);
     }
 }
\ No newline at end of file
@@ -1,4 +1,12 @@
 #pragma once
+#include <core/core.h>
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
 namespace lib
 {
     template<std::size_t Height, std::size_t Width, typename T>
@@ -7,6 +15,29 @@ namespace lib
         std::array<T, Height* Width> values;
     };
 
+    template<typename Kernel>
+    struct kernel_traits;
+
+    // The anchor is the tap that lies on the output pixel in a full size convolution, the center of uneven sizes and
+    // the top left of the central 2x2 taps of even ones
+    template<std::size_t Height, std::size_t Width, typename T>
+    struct kernel_traits<kernel<Height, Width, T>>
+    {
+        static constexpr std::size_t height = Height;
+        static constexpr std::size_t width = Width;
+        static constexpr std::size_t anchor_row = (Height - 1) / 2;
+        static constexpr std::size_t anchor_col = (Width - 1) / 2;
+        using value_type = T;
+    };
+
+    // A rank-1 kernel stored as the two factors of its outer product: value(r, c) = column[r] * row[c]
+    template<std::size_t Height, std::size_t Width, typename T>
+    struct separable_kernel
+    {
+        std::array<T, Height> column;
+        std::array<T, Width> row;
+    };
+
     template <std::size_t Height, std::size_t Width, typename T, typename... Params>
     constexpr kernel<Height, Width, T> make_kernel(Params&& ... args)
     {
@@ -15,6 +46,243 @@ namespace lib
         return output;
     }
 
+    template <std::size_t Height, std::size_t Width, typename T>
+    constexpr kernel<Height, Width, T> make_kernel(const separable_kernel<Height, Width, T>& factors)
+    {
+        auto output = kernel<Height, Width, T>();
+        for (std::size_t r = 0; r < Height; r++)
+            for (std::size_t c = 0; c < Width; c++)
+                output.values[r * Width + c] = static_cast<T>(factors.column[r] * factors.row[c]);
+        return output;
+    }
+
+    template <std::size_t Height, std::size_t Width, typename T>
+    constexpr separable_kernel<Height, Width, T> make_separable_kernel(const std::array<T, Height>& column, const std::array<T, Width>& row)
+    {
+        return separable_kernel<Height, Width, T>{ column, row };
+    }
+
+    // A kernel whose size is only known at runtime, values are stored row major like in kernel
+    template<typename T>
+    struct dynamic_kernel
+    {
+        int height = 0;
+        int width = 0;
+        std::vector<T> values;
+    };
+
+    template <typename T>
+    dynamic_kernel<T> make_dynamic_kernel(int height, int width, std::vector<T> values)
+    {
+        throw_assert(height > 0 && width > 0, "Kernel size must be positive, but was " << height << "x" << width << ".")
+        throw_assert(values.size() == static_cast<std::size_t>(height) * width, "Kernel of size " << height << "x" << width << " needs " << height * width << " values, but got " << values.size() << ".")
+        return dynamic_kernel<T>{ height, width, std::move(values) };
+    }
+
+    template <std::size_t Height, std::size_t Width, typename T>
+    dynamic_kernel<T> make_dynamic_kernel(const kernel<Height, Width, T>& kernel)
+    {
+        return dynamic_kernel<T>{ static_cast<int>(Height), static_cast<int>(Width), std::vector<T>(kernel.values.begin(), kernel.values.end()) };
+    }
+
+    // size x size Gaussian with the given standard deviation. Floating point kernels sum up to 1, integral kernels are
+    // scaled so the corner coefficients become 1, like gaussian_blur.
+    template <typename T>
+    dynamic_kernel<T> make_gaussian_kernel(int size, double sigma = 1.0)
+    {
+        throw_assert(size % 2 == 1 && size > 0, "Kernel size must be uneven, but was " << size << ".")
+        throw_assert(sigma > 0, "Sigma must be positive, but was " << sigma << ".")
+
+        const auto range = size / 2;
+        auto weights = std::vector<double>(static_cast<std::size_t>(size) * size);
+        for (int y = -range; y <= range; y++)
+            for (int x = -range; x <= range; x++)
+                weights[static_cast<std::size_t>(y + range) * size + (x + range)] = std::exp(-(x * x + y * y) / (2.0 * sigma * sigma));
+
+        const auto scale = std::is_floating_point_v<T> ? std::accumulate(weights.begin(), weights.end(), 0.0) : weights.front();
+        auto output = dynamic_kernel<T>{ size, size, std::vector<T>(weights.size()) };
+        for (std::size_t i = 0; i < weights.size(); i++)
+            output.values[i] = std::is_floating_point_v<T> ? static_cast<T>(weights[i] / scale) : static_cast<T>(std::round(weights[i] / scale));
+        return output;
+    }
+
+    namespace internal
+    {
+        // Integral kernels are checked exactly, floating point kernels within a few ulps of the largest coefficient
+        template <typename T>
+        using rank_check_type = std::conditional_t<std::is_integral_v<T>, long long, long double>;
+
+        template <typename T>
+        constexpr T constexpr_abs(T value)
+        {
+            return value < T{ 0 } ? -value : value;
+        }
+
+        // Index of the coefficient with the largest magnitude, used as pivot for the factorization
+        template <std::size_t Height, std::size_t Width, typename T>
+        constexpr std::size_t pivot_index(const kernel<Height, Width, T>& kernel)
+        {
+            std::size_t pivot = 0;
+            for (std::size_t i = 1; i < Height * Width; i++)
+            {
+                if (constexpr_abs<rank_check_type<T>>(kernel.values[i]) > constexpr_abs<rank_check_type<T>>(kernel.values[pivot]))
+                    pivot = i;
+            }
+            return pivot;
+        }
+    }
+
+    // True if the kernel is the outer product of a column and a row vector (matrix rank <= 1)
+    template <std::size_t Height, std::size_t Width, typename T>
+    constexpr bool is_separable(const kernel<Height, Width, T>& kernel)
+    {
+        using check_type = internal::rank_check_type<T>;
+
+        const auto pivot = internal::pivot_index(kernel);
+        const auto pivot_row = pivot / Width;
+        const auto pivot_col = pivot % Width;
+        const auto pivot_value = static_cast<check_type>(kernel.values[pivot]);
+
+        if (pivot_value == check_type{ 0 })
+            return true;
+
+        auto tolerance = check_type{ 0 };
+        if constexpr (std::is_floating_point_v<T>)
+            tolerance = 8 * static_cast<check_type>(std::numeric_limits<T>::epsilon()) * pivot_value * pivot_value;
+
+        // Every 2x2 minor through the pivot has to vanish
+        for (std::size_t r = 0; r < Height; r++)
+        {
+            for (std::size_t c = 0; c < Width; c++)
+            {
+                auto minor = static_cast<check_type>(kernel.values[r * Width + c]) * pivot_value -
+                    static_cast<check_type>(kernel.values[r * Width + pivot_col]) * static_cast<check_type>(kernel.values[pivot_row * Width + c]);
+                if (internal::constexpr_abs(minor) > tolerance)
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    // Factorizes a kernel for which is_separable() holds. Integral kernels get integral factors whose
+    // column has no common divisor, e.g. gaussian_blur becomes (1, 2, 1) x (1, 2, 1).
+    template <std::size_t Height, std::size_t Width, typename T>
+    constexpr separable_kernel<Height, Width, T> separate(const kernel<Height, Width, T>& kernel)
+    {
+        using check_type = internal::rank_check_type<T>;
+
+        auto output = separable_kernel<Height, Width, T>();
+        const auto pivot = internal::pivot_index(kernel);
+        const auto pivot_row = pivot / Width;
+        const auto pivot_col = pivot % Width;
+
+        if (kernel.values[pivot] == T{ 0 })
+            return output;
+
+        if constexpr (std::is_integral_v<T>)
+        {
+            auto divisor = check_type{ 0 };
+            for (std::size_t r = 0; r < Height; r++)
+                divisor = std::gcd(divisor, static_cast<check_type>(kernel.values[r * Width + pivot_col]));
+
+            for (std::size_t r = 0; r < Height; r++)
+                output.column[r] = static_cast<T>(static_cast<check_type>(kernel.values[r * Width + pivot_col]) / divisor);
+
+            const auto row_divisor = static_cast<check_type>(output.column[pivot_row]);
+            for (std::size_t c = 0; c < Width; c++)
+                output.row[c] = static_cast<T>(static_cast<check_type>(kernel.values[pivot_row * Width + c]) / row_divisor);
+        }
+        else
+        {
+            for (std::size_t r = 0; r < Height; r++)
+                output.column[r] = kernel.values[r * Width + pivot_col];
+
+            for (std::size_t c = 0; c < Width; c++)
+                output.row[c] = kernel.values[pivot_row * Width + c] / kernel.values[pivot];
+        }
+        return output;
+    }
+
+
+    namespace internal
+    {
+        // Row Size - 1 of pascal's triangle, the binomial smoothing weights
+        template <std::size_t Size, typename T>
+        constexpr std::array<T, Size> binomial_weights()
+        {
+            auto output = std::array<T, Size>();
+            output[0] = T{ 1 };
+            for (std::size_t n = 1; n < Size; n++)
+                for (std::size_t k = n; k > 0; k--)
+                    output[k] = output[k] + output[k - 1];
+            return output;
+        }
+
+        // The central difference (1, 0, -1) smoothed by binomial weights of size Size - 2
+        template <std::size_t Size, typename T>
+        constexpr std::array<T, Size> derivative_weights()
+        {
+            const auto smoothing = binomial_weights<Size - 2, T>();
+            auto output = std::array<T, Size>();
+            for (std::size_t i = 0; i < Size - 2; i++)
+            {
+                output[i] = output[i] + smoothing[i];
+                output[i + 2] = output[i + 2] - smoothing[i];
+            }
+            return output;
+        }
+    }
+
+    // Size x Size sobel operator as separable factors, a binomial smoothing across the derivative direction and the
+    // smoothed central difference along it. Size 3 gives kernels::sobel_h and kernels::sobel_v.
+    template <std::size_t Size, typename T>
+    constexpr separable_kernel<Size, Size, T> make_sobel_h_factors()
+    {
+        static_assert(Size % 2 == 1 && Size >= 3, "Sobel size must be uneven and at least 3.");
+        return make_separable_kernel<Size, Size, T>(internal::binomial_weights<Size, T>(), internal::derivative_weights<Size, T>());
+    }
+
+    template <std::size_t Size, typename T>
+    constexpr separable_kernel<Size, Size, T> make_sobel_v_factors()
+    {
+        static_assert(Size % 2 == 1 && Size >= 3, "Sobel size must be uneven and at least 3.");
+        return make_separable_kernel<Size, Size, T>(internal::derivative_weights<Size, T>(), internal::binomial_weights<Size, T>());
+    }
+
+    // The 3x3 Scharr operator, sobel with the (3, 10, 3) smoothing that makes the response nearly rotation invariant
+    template <typename T>
+    constexpr separable_kernel<3, 3, T> make_scharr_h_factors()
+    {
+        return make_separable_kernel<3, 3, T>({ T{ 3 }, T{ 10 }, T{ 3 } }, { T{ 1 }, T{ 0 }, T{ -1 } });
+    }
+
+    template <typename T>
+    constexpr separable_kernel<3, 3, T> make_scharr_v_factors()
+    {
+        return make_separable_kernel<3, 3, T>({ T{ 1 }, T{ 0 }, T{ -1 } }, { T{ 3 }, T{ 10 }, T{ 3 } });
+    }
+
+    // Turns the outer ring of a 3x3 kernel one step (45 degrees) clockwise, the center stays in place
+    template <typename T>
+    constexpr kernel<3, 3, T> rotate_45(const kernel<3, 3, T>& kernel)
+    {
+        constexpr std::size_t ring[8] = { 0, 1, 2, 5, 8, 7, 6, 3 };
+        auto output = kernel;
+        for (std::size_t i = 0; i < 8; i++)
+            output.values[ring[(i + 1) % 8]] = kernel.values[ring[i]];
+        return output;
+    }
+
+    // The eight rotations of a 3x3 kernel, entry i is turned by i * 45 degrees
+    template <typename T>
+    constexpr std::array<kernel<3, 3, T>, 8> make_compass_kernels(const kernel<3, 3, T>& kernel)
+    {
+        auto output = std::array<lib::kernel<3, 3, T>, 8>();
+        output[0] = kernel;
+        for (std::size_t i = 1; i < 8; i++)
+            output[i] = rotate_45(output[i - 1]);
+        return output;
+    }
 
     namespace kernels
     {
@@ -32,6 +300,63 @@ namespace lib
             -1, -2, -1
             );
 
+        template <typename T>
+        constexpr auto sobel_h_5 = make_kernel(make_sobel_h_factors<5, T>());
+
+        template <typename T>
+        constexpr auto sobel_v_5 = make_kernel(make_sobel_v_factors<5, T>());
+
+        template <typename T>
+        constexpr auto sobel_h_7 = make_kernel(make_sobel_h_factors<7, T>());
+
+        template <typename T>
+        constexpr auto sobel_v_7 = make_kernel(make_sobel_v_factors<7, T>());
+
+        template <typename T>
+        constexpr auto scharr_h = make_kernel(make_scharr_h_factors<T>());
+
+        template <typename T>
+        constexpr auto scharr_v = make_kernel(make_scharr_v_factors<T>());
+
+        template <typename T>
+        constexpr auto roberts_h = make_kernel<2, 2, T>(
+            1, 0,
+            0, -1
+            );
+
+        template <typename T>
+        constexpr auto roberts_v = make_kernel<2, 2, T>(
+            0, 1,
+            -1, 0
+            );
+
+        template <typename T>
+        constexpr auto prewitt_h = make_kernel<3, 3, T>(
+            -1, 0, 1,
+            -1, 0, 1,
+            -1, 0, 1
+            );
+
+        template <typename T>
+        constexpr auto prewitt_v = make_kernel<3, 3, T>(
+            -1, -1, -1,
+            0, 0, 0,
+            1, 1, 1
+            );
+
+        template <typename T>
+        constexpr auto kirsch = make_kernel<3, 3, T>(
+            5, 5, 5,
+            -3, 0, -3,
+            -3, -3, -3
+            );
+
+        template <typename T>
+        constexpr auto prewitt_compass = make_compass_kernels(prewitt_h<T>);
+
+        template <typename T>
+        constexpr auto kirsch_compass = make_compass_kernels(kirsch<T>);
+
         template <typename T>
         constexpr auto identity = make_kernel<3, 3, T>(
             0, 0, 0,
@@ -53,4 +378,4 @@ namespace lib
             1, 2, 1
             );
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,256 @@
+#pragma once
+#include <core/core.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+#include "convolve.h"
+#include "pixel.h"
+
+namespace lib
+{
+    // How laplacian_of_gaussian evaluates the filter. Both run as two separable convolutions instead of one dense
+    // size x size kernel.
+    enum class laplacian_mode
+    {
+        Separable,              // g''(x) g(y) + g(x) g''(y), the exact LoG of the truncated gaussian
+        DifferenceOfGaussians   // G(sigma * sqrt(1.6)) - G(sigma / sqrt(1.6)), scaled to the LoG
+    };
+
+    namespace internal
+    {
+        // Normalized 1D gaussian of the given size
+        inline std::vector<double> gaussian_weights(int size, double sigma)
+        {
+            const auto range = size / 2;
+            auto weights = std::vector<double>(static_cast<std::size_t>(size));
+            for (int x = -range; x <= range; x++)
+                weights[static_cast<std::size_t>(x + range)] = std::exp(-(x * x) / (2.0 * sigma * sigma));
+
+            const auto sum = std::accumulate(weights.begin(), weights.end(), 0.0);
+            for (auto& weight : weights)
+                weight /= sum;
+            return weights;
+        }
+
+        // The row and column factors of two separable kernels whose sum is the filter
+        template<typename T>
+        struct separable_pair
+        {
+            std::vector<T> first_row, first_column, second_row, second_column;
+        };
+
+        template<typename T>
+        separable_pair<T> make_laplacian_factors(int size, double sigma, laplacian_mode mode)
+        {
+            const auto cast = [](const std::vector<double>& values) { return std::vector<T>(values.begin(), values.end()); };
+            if (mode == laplacian_mode::DifferenceOfGaussians)
+            {
+                // d/dsigma G = sigma * LoG, so the difference over [sigma / sqrt(k), sigma * sqrt(k)] is divided by that
+                const auto root_k = std::sqrt(1.6);
+                const auto narrow = gaussian_weights(size, sigma / root_k);
+                const auto wide = gaussian_weights(size, sigma * root_k);
+                const auto scale = 1.0 / (sigma * sigma * (root_k - 1.0 / root_k));
+
+                auto wide_column = wide;
+                auto narrow_column = narrow;
+                for (auto& weight : wide_column)
+                    weight *= scale;
+                for (auto& weight : narrow_column)
+                    weight *= -scale;
+                return { cast(wide), cast(wide_column), cast(narrow), cast(narrow_column) };
+            }
+
+            // g'' is shifted by a multiple of g to sum up to 0, so flat regions give exactly no response
+            const auto range = size / 2;
+            const auto gaussian = gaussian_weights(size, sigma);
+            auto second = std::vector<double>(gaussian.size());
+            for (int x = -range; x <= range; x++)
+                second[static_cast<std::size_t>(x + range)] = (x * x - sigma * sigma) / (sigma * sigma * sigma * sigma) * gaussian[static_cast<std::size_t>(x + range)];
+            const auto sum = std::accumulate(second.begin(), second.end(), 0.0);
+            for (std::size_t i = 0; i < second.size(); i++)
+                second[i] -= sum * gaussian[i];
+            return { cast(second), cast(gaussian), cast(gaussian), cast(second) };
+        }
+
+        // Correlates the rows with a runtime sized row factor, output has (cols - (size - 1)) columns
+        template<typename T>
+        void convolve_rows(const T* input, std::ptrdiff_t input_stride, T* output, std::ptrdiff_t output_stride, int rows, int cols, const std::vector<T>& row)
+        {
+            const auto size = static_cast<int>(row.size());
+            if (convolve_vectorized(input, input_stride, output, output_stride, rows, cols, row.data(), 1, size))
+                return;
+
+            for (int y = 0; y < rows; y++)
+            {
+                const auto* input_row = input + y * input_stride;
+                auto* output_row = output + y * output_stride;
+                std::fill(output_row, output_row + cols, T{ 0 });
+                for (int tap = 0; tap < size; tap++)
+                {
+                    for (int x = 0; x < cols; x++)
+                        output_row[x] += input_row[x + tap] * row[tap];
+                }
+            }
+        }
+
+        // Sums the column passes of both intermediates into the output rows [first_row, last_row), tap by tap over whole
+        // rows so the inner loop vectorizes
+        template<typename T>
+        void sum_column_passes(const T* first, const T* second, std::ptrdiff_t stride, const std::vector<T>& first_column, const std::vector<T>& second_column,
+            T* output, std::ptrdiff_t output_stride, int first_row, int last_row, int cols)
+        {
+            const auto size = static_cast<int>(first_column.size());
+            for (int row = first_row; row < last_row; row++)
+            {
+                auto* output_row = output + row * output_stride;
+                std::fill(output_row, output_row + cols, T{ 0 });
+                for (int tap = 0; tap < size; tap++)
+                {
+                    const auto* first_row_in = first + (row + tap) * stride;
+                    const auto* second_row_in = second + (row + tap) * stride;
+                    const auto a = first_column[tap];
+                    const auto b = second_column[tap];
+                    for (int col = 0; col < cols; col++)
+                        output_row[col] += first_row_in[col] * a + second_row_in[col] * b;
+                }
+            }
+        }
+    }
+
+    // Laplacian of gaussian, the second derivative response whose zero crossings mark edges. The size x size filter runs
+    // as the sum of two separable convolutions, 4 * size multiplications per pixel instead of size^2. Like convolve, the
+    // result is size - 1 rows and columns smaller than the input.
+    template<typename ExecutionPolicy, typename T, typename Deleter, typename OutputDeleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    void laplacian_of_gaussian_into(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, array2d<T, OutputDeleter>& output,
+        int size, double sigma, laplacian_mode mode = laplacian_mode::Separable)
+    {
+        static_assert(std::is_floating_point_v<T>, "Image must be floating point.");
+        throw_assert(size % 2 == 1 && size > 0, "Kernel size must be uneven, but was " << size << ".")
+        throw_assert(sigma > 0, "Sigma must be positive, but was " << sigma << ".")
+
+        // Inputs smaller than the kernel give an empty result, like the allocating overload
+        const auto rows = std::max(0, input.rows() - (size - 1));
+        const auto cols = std::max(0, input.cols() - (size - 1));
+        internal::check_output_shape(output, rows, cols);
+        if (rows <= 0 || cols <= 0)
+            return;
+
+        const auto factors = internal::make_laplacian_factors<T>(size, sigma, mode);
+        const auto halo = size - 1;
+        const auto strip = internal::strip_rows<T>(cols, halo, 2);
+
+        // Both row passes of a strip go through the two halves of one band buffer, the size - 1 halo rows a strip
+        // shares with the next one are filtered twice
+        execution::for_each_row_band(policy, rows, [&](int first_row, int last_row)
+            {
+                const auto strip_input_rows = std::min(strip, last_row - first_row) + halo;
+                auto intermediates = internal::make_band_buffer<T>(2 * strip_input_rows, cols);
+                const auto stride = static_cast<std::ptrdiff_t>(intermediates.stride());
+                auto* first = intermediates.data();
+                auto* second = first + strip_input_rows * stride;
+                for (auto strip_first = first_row; strip_first < last_row; strip_first += strip)
+                {
+                    const auto strip_last = std::min(last_row, strip_first + strip);
+                    const auto* strip_input = input.data() + static_cast<std::size_t>(strip_first) * input.stride();
+                    internal::convolve_rows(strip_input, input.stride(), first, stride, strip_last - strip_first + halo, cols, factors.first_row);
+                    internal::convolve_rows(strip_input, input.stride(), second, stride, strip_last - strip_first + halo, cols, factors.second_row);
+                    internal::sum_column_passes(first, second, stride, factors.first_column, factors.second_column,
+                        output.data() + static_cast<std::size_t>(strip_first) * output.stride(), output.stride(), 0, strip_last - strip_first, cols);
+                }
+            });
+    }
+
+    template<typename T, typename Deleter, typename OutputDeleter>
+    void laplacian_of_gaussian_into(const array2d<T, Deleter>& input, array2d<T, OutputDeleter>& output, int size, double sigma,
+        laplacian_mode mode = laplacian_mode::Separable)
+    {
+        laplacian_of_gaussian_into(execution::seq, input, output, size, sigma, mode);
+    }
+
+    template<typename ExecutionPolicy, typename T, typename Deleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    array2d<T> laplacian_of_gaussian(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, int size, double sigma,
+        laplacian_mode mode = laplacian_mode::Separable)
+    {
+        auto result = array2d<T>(std::max(0, input.rows() - (size - 1)), std::max(0, input.cols() - (size - 1)));
+        laplacian_of_gaussian_into(policy, input, result, size, sigma, mode);
+        return result;
+    }
+
+    template<typename T, typename Deleter>
+    array2d<T> laplacian_of_gaussian(const array2d<T, Deleter>& input, int size, double sigma, laplacian_mode mode = laplacian_mode::Separable)
+    {
+        return laplacian_of_gaussian(execution::seq, input, size, sigma, mode);
+    }
+
+    namespace internal
+    {
+        // A pixel is a crossing if one of its 8 neighbours has the opposite sign, the two differ by more than the
+        // threshold and the pixel is the one closer to zero, the negative one on a tie. So every crossing is marked on
+        // one side only, and the near zero noise of flat regions never pairs up with a strong response.
+        template<typename T>
+        void zero_crossing_rows(const T* input, std::ptrdiff_t stride, int rows, int cols, T threshold, std::uint8_t* output, std::ptrdiff_t output_stride,
+            int first_row, int last_row)
+        {
+            const std::ptrdiff_t offsets[8] = { -stride - 1, -stride, -stride + 1, -1, 1, stride - 1, stride, stride + 1 };
+            for (int row = std::max(first_row, 1); row < std::min(last_row, rows - 1); row++)
+            {
+                const auto* input_row = input + row * stride;
+                auto* output_row = output + row * output_stride;
+                for (int col = 1; col < cols - 1; col++)
+                {
+                    const auto value = input_row[col];
+                    auto edge = false;
+                    for (const auto offset : offsets)
+                    {
+                        const auto neighbour = input_row[col + offset];
+                        const auto closer = std::abs(value) < std::abs(neighbour) || (std::abs(value) == std::abs(neighbour) && value < T{ 0 });
+                        edge |= (value * neighbour < T{ 0 }) & (std::abs(value - neighbour) > threshold) & closer;
+                    }
+                    output_row[col] = edge ? std::uint8_t{ 255 } : std::uint8_t{ 0 };
+                }
+            }
+        }
+    }
+
+    // Edge map of a laplacian response, 255 on the zero crossings whose two sides differ by more than the threshold and
+    // 0 elsewhere, including the one pixel wide frame. Same size as the input, the lines are one pixel wide.
+    template<typename ExecutionPolicy, typename T, typename Deleter, typename OutputDeleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    void zero_crossings_into(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, array2d<std::uint8_t, OutputDeleter>& output, double threshold)
+    {
+        static_assert(std::is_floating_point_v<T>, "Image must be floating point.");
+
+        internal::check_output_shape(output, input.rows(), input.cols());
+        std::fill(output.begin(), output.end(), std::uint8_t{ 0 });
+        execution::for_each_row_band(policy, input.rows(), [&](int first_row, int last_row)
+            {
+                internal::zero_crossing_rows(input.data(), input.stride(), input.rows(), input.cols(), static_cast<T>(threshold), output.data(), output.stride(),
+                    first_row, last_row);
+            });
+    }
+
+    template<typename T, typename Deleter, typename OutputDeleter>
+    void zero_crossings_into(const array2d<T, Deleter>& input, array2d<std::uint8_t, OutputDeleter>& output, double threshold)
+    {
+        zero_crossings_into(execution::seq, input, output, threshold);
+    }
+
+    template<typename ExecutionPolicy, typename T, typename Deleter,
+        typename = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>>
+    array2d<std::uint8_t> zero_crossings(const ExecutionPolicy& policy, const array2d<T, Deleter>& input, double threshold)
+    {
+        auto result = array2d<std::uint8_t>(input.rows(), input.cols());
+        zero_crossings_into(policy, input, result, threshold);
+        return result;
+    }
+
+    template<typename T, typename Deleter>
+    array2d<std::uint8_t> zero_crossings(const array2d<T, Deleter>& input, double threshold)
+    {
+        return zero_crossings(execution::seq, input, threshold);
+    }
+}
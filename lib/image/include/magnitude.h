@@ -0,0 +1,101 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace lib
+{
+    // How sobel combines the two directional gradients gx and gy into one value
+    enum class magnitude_mode
+    {
+        L2,             // sqrt(gx^2 + gy^2)
+        L1,             // |gx| + |gy|
+        Squared,        // gx^2 + gy^2, compare against a squared threshold. Exact on integral outputs of at least
+                        // 32 bit up to their maximum, where it saturates, e.g. gradients up to 46340 for int. Float
+                        // outputs clamp to 1 like the other modes. 8 and 16 bit outputs are rejected.
+        Approximate     // 31/32 max(|gx|, |gy|) + 3/8 min(|gx|, |gy|), within 5% of L2
+    };
+
+    namespace internal
+    {
+        // Integral images are differentiated in int so the negative kernel weights can not wrap around
+        template<typename T>
+        using gradient_type = std::conditional_t<std::is_floating_point_v<T>, T, int>;
+
+        // Calls body(std::integral_constant<magnitude_mode, Mode>{}), so per pixel code is compiled once per mode
+        template<typename F>
+        decltype(auto) dispatch_magnitude(magnitude_mode mode, F&& body)
+        {
+            switch (mode)
+            {
+            case magnitude_mode::L1: return body(std::integral_constant<magnitude_mode, magnitude_mode::L1>{});
+            case magnitude_mode::Squared: return body(std::integral_constant<magnitude_mode, magnitude_mode::Squared>{});
+            case magnitude_mode::Approximate: return body(std::integral_constant<magnitude_mode, magnitude_mode::Approximate>{});
+            default: return body(std::integral_constant<magnitude_mode, magnitude_mode::L2>{});
+            }
+        }
+
+        // The approximation weights are dyadic, so integral gradients give exact products in float
+        template<magnitude_mode Mode, typename F>
+        F combine_gradients(F x, F y)
+        {
+            if constexpr (Mode == magnitude_mode::L2)
+            {
+                return std::sqrt(x * x + y * y);
+            }
+            else if constexpr (Mode == magnitude_mode::L1)
+            {
+                return std::abs(x) + std::abs(y);
+            }
+            else if constexpr (Mode == magnitude_mode::Squared)
+            {
+                return x * x + y * y;
+            }
+            else
+            {
+                const auto ax = std::abs(x);
+                const auto ay = std::abs(y);
+                return std::max(ax, ay) * F{ 0.96875 } + std::min(ax, ay) * F{ 0.375 };
+            }
+        }
+
+        // The squared magnitudes of 8-bit gradients reach 2 * 1020^2 already, narrower integral outputs can not hold them
+        template<typename T>
+        void check_magnitude_mode(magnitude_mode mode)
+        {
+            if (std::is_integral_v<T> && sizeof(T) < sizeof(std::int32_t) && mode == magnitude_mode::Squared)
+                throw std::invalid_argument("Squared magnitudes need a floating point or at least 32 bit integral output.");
+        }
+
+        // The vector kernels combine the gradients in float, which rounds squared magnitudes of integral images
+        // beyond 2^24, those go through the exact scalar code
+        template<typename T>
+        bool has_vector_magnitude(magnitude_mode mode)
+        {
+            return std::is_floating_point_v<T> || mode != magnitude_mode::Squared;
+        }
+
+        template<typename T, magnitude_mode Mode = magnitude_mode::L2>
+        T gradient_magnitude(gradient_type<T> gx, gradient_type<T> gy)
+        {
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                return std::clamp(combine_gradients<Mode>(gx, gy), T{ 0 }, T{ 1 });
+            }
+            else if constexpr (Mode == magnitude_mode::Squared)
+            {
+                const auto squared = std::int64_t{ gx } * gx + std::int64_t{ gy } * gy;
+                return squared >= static_cast<std::int64_t>(std::numeric_limits<T>::max()) ? std::numeric_limits<T>::max() : static_cast<T>(squared);
+            }
+            else
+            {
+                // Computed in float like the vectorized kernels, exact for 8-bit input
+                const auto magnitude = combine_gradients<Mode>(static_cast<float>(gx), static_cast<float>(gy));
+                return magnitude >= static_cast<float>(std::numeric_limits<T>::max()) ? std::numeric_limits<T>::max() : static_cast<T>(magnitude);
+            }
+        }
+    }
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include <core/core.h>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "magnitude.h"
+
+namespace lib::simd
+{
+    // Row major 2D correlation of a (rows + kernel_rows - 1) x (cols + kernel_cols - 1) input
+    // into a rows x cols output. Strides are given in elements.
+    template <typename T>
+    using convolve_function = void(*)(const T* input, std::ptrdiff_t input_stride, T* output, std::ptrdiff_t output_stride,
+        int rows, int cols, const T* kernel, int kernel_rows, int kernel_cols);
+
+    // 3x3 Sobel gradient magnitude of a (rows + 2) x (cols + 2) input into a rows x cols output
+    template <typename T>
+    using sobel_function = void(*)(const T* input, std::ptrdiff_t input_stride, T* output, std::ptrdiff_t output_stride,
+        int rows, int cols, magnitude_mode magnitude);
+
+    // 2x2 Roberts cross gradient magnitude of a (rows + 1) x (cols + 1) input into a rows x cols output, same signature as sobel
+    template <typename T>
+    using roberts_function = sobel_function<T>;
+
+    // Fixed point correlation of 8-bit pixels with integer coefficients accumulated in int16 lanes, every output is
+    // (rounding + sum) >> shift saturated to TOut. The caller guarantees that no partial sum leaves the int16 range.
+    template <typename TOut>
+    using fixed_convolve_function = void(*)(const std::uint8_t* input, std::ptrdiff_t input_stride, TOut* output, std::ptrdiff_t output_stride,
+        int rows, int cols, const std::int16_t* kernel, int kernel_rows, int kernel_cols, int shift);
+
+    struct kernel_table
+    {
+        simd_level level;
+        convolve_function<float> convolve_f32;
+        convolve_function<std::int32_t> convolve_i32;
+        convolve_function<std::uint8_t> convolve_u8;
+        sobel_function<float> sobel_f32;
+        sobel_function<std::int32_t> sobel_i32;
+        sobel_function<std::uint8_t> sobel_u8;
+        roberts_function<float> roberts_f32;
+        roberts_function<std::int32_t> roberts_i32;
+        roberts_function<std::uint8_t> roberts_u8;
+        fixed_convolve_function<std::uint8_t> fixed_convolve_u8;
+        fixed_convolve_function<std::int16_t> fixed_convolve_s16;
+    };
+
+    template <typename T>
+    struct is_vectorized : std::bool_constant<
+        std::is_same_v<T, float> || std::is_same_v<T, std::int32_t> || std::is_same_v<T, std::uint8_t>> {};
+
+    template <typename T>
+    constexpr bool is_vectorized_v = is_vectorized<T>::value;
+
+    // Kernels of the active level, nullptr if only the scalar template implementation is available
+    const kernel_table* active_kernels();
+
+    simd_level active_level();
+
+    // Restricts dispatch to at most the given level (clamped to what the CPU supports), returns the active level.
+    // Selecting simd_level::Scalar forces the template implementation, e.g. as a reference in tests.
+    simd_level set_level(simd_level level);
+
+    template <typename T>
+    convolve_function<T> convolve_kernel()
+    {
+        static_assert(is_vectorized_v<T>, "No vectorized implementation for this type.");
+        const auto* kernels = active_kernels();
+        if (kernels == nullptr)
+            return nullptr;
+
+        if constexpr (std::is_same_v<T, float>)
+            return kernels->convolve_f32;
+        else if constexpr (std::is_same_v<T, std::int32_t>)
+            return kernels->convolve_i32;
+        else
+            return kernels->convolve_u8;
+    }
+
+    template <typename T>
+    sobel_function<T> sobel_kernel()
+    {
+        static_assert(is_vectorized_v<T>, "No vectorized implementation for this type.");
+        const auto* kernels = active_kernels();
+        if (kernels == nullptr)
+            return nullptr;
+
+        if constexpr (std::is_same_v<T, float>)
+            return kernels->sobel_f32;
+        else if constexpr (std::is_same_v<T, std::int32_t>)
+            return kernels->sobel_i32;
+        else
+            return kernels->sobel_u8;
+    }
+
+    template <typename T>
+    roberts_function<T> roberts_kernel()
+    {
+        static_assert(is_vectorized_v<T>, "No vectorized implementation for this type.");
+        const auto* kernels = active_kernels();
+        if (kernels == nullptr)
+            return nullptr;
+
+        if constexpr (std::is_same_v<T, float>)
+            return kernels->roberts_f32;
+        else if constexpr (std::is_same_v<T, std::int32_t>)
+            return kernels->roberts_i32;
+        else
+            return kernels->roberts_u8;
+    }
+
+    template <typename TOut>
+    fixed_convolve_function<TOut> fixed_convolve_kernel()
+    {
+        static_assert(std::is_same_v<TOut, std::uint8_t> || std::is_same_v<TOut, std::int16_t>, "Fixed point output must be uint8_t or int16_t.");
+        const auto* kernels = active_kernels();
+        if (kernels == nullptr)
+            return nullptr;
+
+        if constexpr (std::is_same_v<TOut, std::uint8_t>)
+            return kernels->fixed_convolve_u8;
+        else
+            return kernels->fixed_convolve_s16;
+    }
+}
@@ -0,0 +1,56 @@
+#include "../../include/simd.h"
+#include <algorithm>
+#include <atomic>
+
+namespace lib::simd
+{
+    namespace internal
+    {
+#if defined(LIB_ARCH_X86)
+        extern const kernel_table sse41_kernels;
+        extern const kernel_table avx2_kernels;
+        extern const kernel_table avx512_kernels;
+#endif
+
+        const kernel_table* kernels_for(simd_level level)
+        {
+            switch (level)
+            {
+#if defined(LIB_ARCH_X86)
+            case simd_level::AVX512:
+                return &avx512_kernels;
+            case simd_level::AVX2:
+                return &avx2_kernels;
+            case simd_level::SSE41:
+                return &sse41_kernels;
+#endif
+            default:
+                return nullptr;
+            }
+        }
+
+        std::atomic<const kernel_table*>& active_table()
+        {
+            static std::atomic<const kernel_table*> table{ kernels_for(max_simd_level()) };
+            return table;
+        }
+    }
+
+    const kernel_table* active_kernels()
+    {
+        return internal::active_table().load(std::memory_order_relaxed);
+    }
+
+    simd_level active_level()
+    {
+        const auto* kernels = active_kernels();
+        return kernels == nullptr ? simd_level::Scalar : kernels->level;
+    }
+
+    simd_level set_level(simd_level level)
+    {
+        const auto supported = static_cast<simd_level>(std::min(static_cast<int>(level), static_cast<int>(max_simd_level())));
+        internal::active_table().store(internal::kernels_for(supported), std::memory_order_relaxed);
+        return active_level();
+    }
+}
@@ -0,0 +1,90 @@
+#include "simd_kernels.h"
+
+#if defined(LIB_ARCH_X86)
+#include <immintrin.h>
+
+namespace lib::simd::internal
+{
+    struct avx2_ops
+    {
+        using vf = __m256;
+        using vi = __m256i;
+        static constexpr int lanes = 8;
+
+        static vf zero_ps() { return _mm256_setzero_ps(); }
+        static vf set1_ps(float value) { return _mm256_set1_ps(value); }
+        static vf loadu_ps(const float* input) { return _mm256_loadu_ps(input); }
+        static void storeu_ps(float* output, vf value) { _mm256_storeu_ps(output, value); }
+        static vf add_ps(vf a, vf b) { return _mm256_add_ps(a, b); }
+        static vf sub_ps(vf a, vf b) { return _mm256_sub_ps(a, b); }
+        static vf mul_ps(vf a, vf b) { return _mm256_mul_ps(a, b); }
+        static vf fmadd_ps(vf a, vf b, vf c) { return _mm256_fmadd_ps(a, b, c); }
+        static vf min_ps(vf a, vf b) { return _mm256_min_ps(a, b); }
+        static vf max_ps(vf a, vf b) { return _mm256_max_ps(a, b); }
+        static vf sqrt_ps(vf a) { return _mm256_sqrt_ps(a); }
+
+        static vi zero_si() { return _mm256_setzero_si256(); }
+        static vi set1_epi32(std::int32_t value) { return _mm256_set1_epi32(value); }
+        static vi loadu_epi32(const std::int32_t* input) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input)); }
+        static void storeu_epi32(std::int32_t* output, vi value) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(output), value); }
+        static vi add_epi32(vi a, vi b) { return _mm256_add_epi32(a, b); }
+        static vi sub_epi32(vi a, vi b) { return _mm256_sub_epi32(a, b); }
+        static vi mullo_epi32(vi a, vi b) { return _mm256_mullo_epi32(a, b); }
+        template <int N> static vi slli_epi32(vi a) { return _mm256_slli_epi32(a, N); }
+
+
+
+        static vf cvtepi32_ps(vi a) { return _mm256_cvtepi32_ps(a); }
+
+        static vi cvttps_epi32_saturate(vf a)
+        {
+            // Overflowing lanes convert to INT32_MIN, flipping all bits turns them into INT32_MAX
+            const auto converted = _mm256_cvttps_epi32(a);
+            return _mm256_xor_si256(converted, _mm256_cmpeq_epi32(converted, _mm256_set1_epi32(std::numeric_limits<std::int32_t>::min())));
+        }
+
+        using vs = __m256i;
+        static constexpr int lanes16 = 16;
+
+        static vs set1_epi16(std::int16_t value) { return _mm256_set1_epi16(value); }
+        static vs add_epi16(vs a, vs b) { return _mm256_add_epi16(a, b); }
+        static vs sub_epi16(vs a, vs b) { return _mm256_sub_epi16(a, b); }
+        static vs mullo_epi16(vs a, vs b) { return _mm256_mullo_epi16(a, b); }
+        static vs sra_epi16(vs a, int shift) { return _mm256_sra_epi16(a, _mm_cvtsi32_si128(shift)); }
+        template <int N> static vs srli_epi16(vs a) { return _mm256_srli_epi16(a, N); }
+        static vs abs_epi16(vs a) { return _mm256_abs_epi16(a); }
+        static vs min_epi16(vs a, vs b) { return _mm256_min_epi16(a, b); }
+        static vs max_epi16(vs a, vs b) { return _mm256_max_epi16(a, b); }
+
+        static vs load_u8_epi16(const std::uint8_t* input)
+        {
+            return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input)));
+        }
+
+        static vs loadu_epi16(const std::int16_t* input) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input)); }
+        static void storeu_epi16(std::int16_t* output, vs value) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(output), value); }
+
+        static void store_epi16_u8(std::uint8_t* output, vs value)
+        {
+            // Masking to the low byte first keeps the saturating pack from clamping
+            store_epi16_u8_saturate(output, _mm256_and_si256(value, _mm256_set1_epi16(0xff)));
+        }
+
+        static void store_epi16_u8_saturate(std::uint8_t* output, vs value)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm_packus_epi16(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1)));
+        }
+
+        static vi cvtepi16_epi32_low(vs a) { return _mm256_cvtepi16_epi32(_mm256_castsi256_si128(a)); }
+        static vi cvtepi16_epi32_high(vs a) { return _mm256_cvtepi16_epi32(_mm256_extracti128_si256(a, 1)); }
+
+        static vs packs_epi32_epi16(vi low, vi high)
+        {
+            // The pack interleaves the 128 bit halves of its operands
+            return _mm256_permute4x64_epi64(_mm256_packs_epi32(low, high), 0xd8);
+        }
+    };
+
+    extern const kernel_table avx2_kernels = make_kernel_table<avx2_ops>(simd_level::AVX2);
+}
+#endif
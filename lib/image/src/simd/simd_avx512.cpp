@@ -0,0 +1,90 @@
+#include "simd_kernels.h"
+
+#if defined(LIB_ARCH_X86)
+#include <immintrin.h>
+
+namespace lib::simd::internal
+{
+    struct avx512_ops
+    {
+        using vf = __m512;
+        using vi = __m512i;
+        static constexpr int lanes = 16;
+
+        static vf zero_ps() { return _mm512_setzero_ps(); }
+        static vf set1_ps(float value) { return _mm512_set1_ps(value); }
+        static vf loadu_ps(const float* input) { return _mm512_loadu_ps(input); }
+        static void storeu_ps(float* output, vf value) { _mm512_storeu_ps(output, value); }
+        static vf add_ps(vf a, vf b) { return _mm512_add_ps(a, b); }
+        static vf sub_ps(vf a, vf b) { return _mm512_sub_ps(a, b); }
+        static vf mul_ps(vf a, vf b) { return _mm512_mul_ps(a, b); }
+        static vf fmadd_ps(vf a, vf b, vf c) { return _mm512_fmadd_ps(a, b, c); }
+        static vf min_ps(vf a, vf b) { return _mm512_min_ps(a, b); }
+        static vf max_ps(vf a, vf b) { return _mm512_max_ps(a, b); }
+        static vf sqrt_ps(vf a) { return _mm512_sqrt_ps(a); }
+
+        static vi zero_si() { return _mm512_setzero_si512(); }
+        static vi set1_epi32(std::int32_t value) { return _mm512_set1_epi32(value); }
+        static vi loadu_epi32(const std::int32_t* input) { return _mm512_loadu_si512(input); }
+        static void storeu_epi32(std::int32_t* output, vi value) { _mm512_storeu_si512(output, value); }
+        static vi add_epi32(vi a, vi b) { return _mm512_add_epi32(a, b); }
+        static vi sub_epi32(vi a, vi b) { return _mm512_sub_epi32(a, b); }
+        static vi mullo_epi32(vi a, vi b) { return _mm512_mullo_epi32(a, b); }
+        template <int N> static vi slli_epi32(vi a) { return _mm512_slli_epi32(a, N); }
+
+
+
+        static vf cvtepi32_ps(vi a) { return _mm512_cvtepi32_ps(a); }
+
+        static vi cvttps_epi32_saturate(vf a)
+        {
+            const auto converted = _mm512_cvttps_epi32(a);
+            const auto overflow = _mm512_cmpeq_epi32_mask(converted, _mm512_set1_epi32(std::numeric_limits<std::int32_t>::min()));
+            return _mm512_mask_mov_epi32(converted, overflow, _mm512_set1_epi32(std::numeric_limits<std::int32_t>::max()));
+        }
+
+        using vs = __m512i;
+        static constexpr int lanes16 = 32;
+
+        static vs set1_epi16(std::int16_t value) { return _mm512_set1_epi16(value); }
+        static vs add_epi16(vs a, vs b) { return _mm512_add_epi16(a, b); }
+        static vs sub_epi16(vs a, vs b) { return _mm512_sub_epi16(a, b); }
+        static vs mullo_epi16(vs a, vs b) { return _mm512_mullo_epi16(a, b); }
+        static vs sra_epi16(vs a, int shift) { return _mm512_sra_epi16(a, _mm_cvtsi32_si128(shift)); }
+        template <int N> static vs srli_epi16(vs a) { return _mm512_srli_epi16(a, N); }
+        static vs abs_epi16(vs a) { return _mm512_abs_epi16(a); }
+        static vs min_epi16(vs a, vs b) { return _mm512_min_epi16(a, b); }
+        static vs max_epi16(vs a, vs b) { return _mm512_max_epi16(a, b); }
+
+        static vs load_u8_epi16(const std::uint8_t* input)
+        {
+            return _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input)));
+        }
+
+        static vs loadu_epi16(const std::int16_t* input) { return _mm512_loadu_si512(input); }
+        static void storeu_epi16(std::int16_t* output, vs value) { _mm512_storeu_si512(output, value); }
+
+        static void store_epi16_u8(std::uint8_t* output, vs value)
+        {
+            // vpmovwb truncates, matching the modulo 256 behaviour of the other levels
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(output), _mm512_cvtepi16_epi8(value));
+        }
+
+        static void store_epi16_u8_saturate(std::uint8_t* output, vs value)
+        {
+            // vpmovuswb saturates unsigned, so negative lanes are cleared first
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(output), _mm512_cvtusepi16_epi8(_mm512_max_epi16(value, _mm512_setzero_si512())));
+        }
+
+        static vi cvtepi16_epi32_low(vs a) { return _mm512_cvtepi16_epi32(_mm512_castsi512_si256(a)); }
+        static vi cvtepi16_epi32_high(vs a) { return _mm512_cvtepi16_epi32(_mm512_extracti64x4_epi64(a, 1)); }
+
+        static vs packs_epi32_epi16(vi low, vi high)
+        {
+            return _mm512_inserti64x4(_mm512_castsi256_si512(_mm512_cvtsepi32_epi16(low)), _mm512_cvtsepi32_epi16(high), 1);
+        }
+    };
+
+    extern const kernel_table avx512_kernels = make_kernel_table<avx512_ops>(simd_level::AVX512);
+}
+#endif
@@ -0,0 +1,400 @@
+#pragma once
+#include "../../include/simd.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+// Instruction set independent kernel implementations. Every simd_<level>.cpp defines an Ops struct
+// wrapping the intrinsics of its level and instantiates the kernels below, compiled with the matching
+// target flags. Ops has to provide:
+//   vf / vi                       float and int32 vectors with the same lane count
+//   lanes                         elements per vector
+//   zero_ps, set1_ps, loadu_ps, storeu_ps, add_ps, sub_ps, mul_ps, fmadd_ps, min_ps, max_ps, sqrt_ps
+//   zero_si, set1_epi32, loadu_epi32, storeu_epi32, add_epi32, sub_epi32, mullo_epi32, slli_epi32<N>
+//   cvtepi32_ps, cvttps_epi32_saturate (positive overflow becomes INT32_MAX)
+//   vs / lanes16                  int16 vector with twice the lane count of vi
+//   set1_epi16, add_epi16, sub_epi16, mullo_epi16, sra_epi16, srli_epi16<N>, abs_epi16, min_epi16, max_epi16
+//   load_u8_epi16                 zero extends `lanes16` bytes
+//   loadu_epi16, storeu_epi16, store_epi16_u8 (truncating), store_epi16_u8_saturate
+//   cvtepi16_epi32_low/high       sign extends the lower or upper half of the lanes
+//   packs_epi32_epi16             narrows two vi with signed saturation, keeping the lane order
+// Everything here depends on Ops, so each instruction set gets its own instantiations and the linker
+// can never substitute code compiled for a different target.
+namespace lib::simd::internal
+{
+    template <typename Ops>
+    typename Ops::vf abs_ps(typename Ops::vf value)
+    {
+        return Ops::max_ps(value, Ops::sub_ps(Ops::zero_ps(), value));
+    }
+
+    // Vector version of lib::internal::combine_gradients
+    template <typename Ops, magnitude_mode Mode>
+    typename Ops::vf combine_gradients(typename Ops::vf fx, typename Ops::vf fy)
+    {
+        if constexpr (Mode == magnitude_mode::L2)
+        {
+            return Ops::sqrt_ps(Ops::add_ps(Ops::mul_ps(fx, fx), Ops::mul_ps(fy, fy)));
+        }
+        else if constexpr (Mode == magnitude_mode::L1)
+        {
+            return Ops::add_ps(abs_ps<Ops>(fx), abs_ps<Ops>(fy));
+        }
+        else if constexpr (Mode == magnitude_mode::Squared)
+        {
+            return Ops::add_ps(Ops::mul_ps(fx, fx), Ops::mul_ps(fy, fy));
+        }
+        else
+        {
+            const auto ax = abs_ps<Ops>(fx);
+            const auto ay = abs_ps<Ops>(fy);
+            return Ops::add_ps(Ops::mul_ps(Ops::max_ps(ax, ay), Ops::set1_ps(0.96875f)), Ops::mul_ps(Ops::min_ps(ax, ay), Ops::set1_ps(0.375f)));
+        }
+    }
+
+    template <typename Ops, typename T>
+    struct lane;
+
+    template <typename Ops>
+    struct lane<Ops, float>
+    {
+        using vector = typename Ops::vf;
+        using scalar = float;
+        using gradient = float;
+        static constexpr int lanes = Ops::lanes;
+
+        static vector load(const float* input) { return Ops::loadu_ps(input); }
+        static vector load_gradient(const gradient* input) { return Ops::loadu_ps(input); }
+        static void store(float* output, vector value) { Ops::storeu_ps(output, value); }
+        static vector broadcast(scalar value) { return Ops::set1_ps(value); }
+        static vector zero() { return Ops::zero_ps(); }
+        static vector add(vector a, vector b) { return Ops::add_ps(a, b); }
+        static vector sub(vector a, vector b) { return Ops::sub_ps(a, b); }
+        static vector twice(vector a) { return Ops::add_ps(a, a); }
+        static vector multiply_add(vector a, vector b, vector accumulator) { return Ops::fmadd_ps(a, b, accumulator); }
+
+        template <magnitude_mode Mode>
+        static void store_magnitude(float* output, vector gx, vector gy)
+        {
+            const auto magnitude = combine_gradients<Ops, Mode>(gx, gy);
+            Ops::storeu_ps(output, Ops::min_ps(Ops::max_ps(magnitude, Ops::zero_ps()), Ops::set1_ps(1.f)));
+        }
+    };
+
+    template <typename Ops>
+    struct lane<Ops, std::int32_t>
+    {
+        using vector = typename Ops::vi;
+        using scalar = std::int32_t;
+        using gradient = std::int32_t;
+        static constexpr int lanes = Ops::lanes;
+
+        static vector load(const std::int32_t* input) { return Ops::loadu_epi32(input); }
+        static vector load_gradient(const gradient* input) { return Ops::loadu_epi32(input); }
+        static void store(std::int32_t* output, vector value) { Ops::storeu_epi32(output, value); }
+        static vector broadcast(scalar value) { return Ops::set1_epi32(value); }
+        static vector zero() { return Ops::zero_si(); }
+        static vector add(vector a, vector b) { return Ops::add_epi32(a, b); }
+        static vector sub(vector a, vector b) { return Ops::sub_epi32(a, b); }
+        static vector twice(vector a) { return Ops::template slli_epi32<1>(a); }
+        static vector multiply_add(vector a, vector b, vector accumulator) { return Ops::add_epi32(Ops::mullo_epi32(a, b), accumulator); }
+
+        template <magnitude_mode Mode>
+        static void store_magnitude(std::int32_t* output, vector gx, vector gy)
+        {
+            Ops::storeu_epi32(output, Ops::cvttps_epi32_saturate(combine_gradients<Ops, Mode>(Ops::cvtepi32_ps(gx), Ops::cvtepi32_ps(gy))));
+        }
+    };
+
+    // 8-bit pixels are widened to int16 lanes. Sums wrap modulo 2^16, which leaves the low byte the template
+    // implementation wraps to, and 8-bit sobel gradients stay within +-1020.
+    template <typename Ops>
+    struct lane<Ops, std::uint8_t>
+    {
+        using vector = typename Ops::vs;
+        using scalar = std::int16_t;
+        using gradient = std::int16_t;
+        static constexpr int lanes = Ops::lanes16;
+
+        static vector load(const std::uint8_t* input) { return Ops::load_u8_epi16(input); }
+        static vector load_gradient(const gradient* input) { return Ops::loadu_epi16(input); }
+        static void store(std::uint8_t* output, vector value) { Ops::store_epi16_u8(output, value); }
+        static vector broadcast(scalar value) { return Ops::set1_epi16(value); }
+        static vector zero() { return Ops::set1_epi16(0); }
+        static vector add(vector a, vector b) { return Ops::add_epi16(a, b); }
+        static vector sub(vector a, vector b) { return Ops::sub_epi16(a, b); }
+        static vector twice(vector a) { return Ops::add_epi16(a, a); }
+        static vector multiply_add(vector a, vector b, vector accumulator) { return Ops::add_epi16(Ops::mullo_epi16(a, b), accumulator); }
+
+        // Squares of the halves in int32, converted to float only for the square root
+        template <magnitude_mode Mode>
+        static typename Ops::vi combine_half(typename Ops::vi gx, typename Ops::vi gy)
+        {
+            const auto squared = Ops::add_epi32(Ops::mullo_epi32(gx, gx), Ops::mullo_epi32(gy, gy));
+            if constexpr (Mode == magnitude_mode::L2)
+                return Ops::cvttps_epi32_saturate(Ops::sqrt_ps(Ops::cvtepi32_ps(squared)));
+            else
+                return squared;
+        }
+
+        // Integral like the float computation of gradient_magnitude, which is exact for these gradients. The
+        // saturating stores clamp to 255.
+        template <magnitude_mode Mode>
+        static void store_magnitude(std::uint8_t* output, vector gx, vector gy)
+        {
+            if constexpr (Mode == magnitude_mode::L1)
+            {
+                Ops::store_epi16_u8_saturate(output, Ops::add_epi16(Ops::abs_epi16(gx), Ops::abs_epi16(gy)));
+            }
+            else if constexpr (Mode == magnitude_mode::Approximate)
+            {
+                // (31 * max + 12 * min) / 32 reaches 43860, which the logical shift reads as unsigned
+                const auto ax = Ops::abs_epi16(gx);
+                const auto ay = Ops::abs_epi16(gy);
+                const auto weighted = Ops::add_epi16(Ops::mullo_epi16(Ops::max_epi16(ax, ay), Ops::set1_epi16(31)), Ops::mullo_epi16(Ops::min_epi16(ax, ay), Ops::set1_epi16(12)));
+                Ops::store_epi16_u8_saturate(output, Ops::template srli_epi16<5>(weighted));
+            }
+            else
+            {
+                const auto low = combine_half<Mode>(Ops::cvtepi16_epi32_low(gx), Ops::cvtepi16_epi32_low(gy));
+                const auto high = combine_half<Mode>(Ops::cvtepi16_epi32_high(gx), Ops::cvtepi16_epi32_high(gy));
+                Ops::store_epi16_u8_saturate(output, Ops::packs_epi32_epi16(low, high));
+            }
+        }
+    };
+
+    template <typename T>
+    using scalar_accumulator = std::conditional_t<std::is_floating_point_v<T>, T, std::int32_t>;
+
+    template <typename Ops, typename T>
+    void convolve(const T* input, std::ptrdiff_t input_stride, T* output, std::ptrdiff_t output_stride,
+        int rows, int cols, const T* kernel, int kernel_rows, int kernel_cols)
+    {
+        using lane = internal::lane<Ops, T>;
+        constexpr int lanes = lane::lanes;
+
+        for (int y = 0; y < rows; y++)
+        {
+            const T* input_row = input + y * input_stride;
+            T* output_row = output + y * output_stride;
+
+            int x = 0;
+            // Two independent accumulators hide the latency of the multiply-add chain
+            for (; x + 2 * lanes <= cols; x += 2 * lanes)
+            {
+                auto accumulator0 = lane::zero();
+                auto accumulator1 = lane::zero();
+                for (int r = 0; r < kernel_rows; r++)
+                {
+                    const T* tap = input_row + r * input_stride + x;
+                    const T* coefficients = kernel + r * kernel_cols;
+                    for (int c = 0; c < kernel_cols; c++)
+                    {
+                        const auto coefficient = lane::broadcast(static_cast<typename lane::scalar>(coefficients[c]));
+                        accumulator0 = lane::multiply_add(lane::load(tap + c), coefficient, accumulator0);
+                        accumulator1 = lane::multiply_add(lane::load(tap + c + lanes), coefficient, accumulator1);
+                    }
+                }
+                lane::store(output_row + x, accumulator0);
+                lane::store(output_row + x + lanes, accumulator1);
+            }
+
+            for (; x + lanes <= cols; x += lanes)
+            {
+                auto accumulator = lane::zero();
+                for (int r = 0; r < kernel_rows; r++)
+                {
+                    const T* tap = input_row + r * input_stride + x;
+                    const T* coefficients = kernel + r * kernel_cols;
+                    for (int c = 0; c < kernel_cols; c++)
+                        accumulator = lane::multiply_add(lane::load(tap + c), lane::broadcast(static_cast<typename lane::scalar>(coefficients[c])), accumulator);
+                }
+                lane::store(output_row + x, accumulator);
+            }
+
+            for (; x < cols; x++)
+            {
+                auto accumulator = scalar_accumulator<T>{};
+                for (int r = 0; r < kernel_rows; r++)
+                    for (int c = 0; c < kernel_cols; c++)
+                        accumulator += input_row[r * input_stride + x + c] * kernel[r * kernel_cols + c];
+                output_row[x] = static_cast<T>(accumulator);
+            }
+        }
+    }
+
+    template <typename Ops, typename T, magnitude_mode Mode>
+    void sobel_rows(const T* input, std::ptrdiff_t input_stride, T* output, std::ptrdiff_t output_stride, int rows, int cols)
+    {
+        using lane = internal::lane<Ops, T>;
+        constexpr int lanes = lane::lanes;
+
+        for (int y = 0; y < rows; y++)
+        {
+            const T* top = input + y * input_stride;
+            const T* middle = top + input_stride;
+            const T* bottom = middle + input_stride;
+            T* output_row = output + y * output_stride;
+
+            int x = 0;
+            for (; x + lanes <= cols; x += lanes)
+            {
+                const auto top_left = lane::load(top + x);
+                const auto top_right = lane::load(top + x + 2);
+                const auto bottom_left = lane::load(bottom + x);
+                const auto bottom_right = lane::load(bottom + x + 2);
+
+                // sobel_h: (1, 2, 1) column weights on the difference of the outer columns
+                const auto gx = lane::add(
+                    lane::add(lane::sub(top_left, top_right), lane::sub(bottom_left, bottom_right)),
+                    lane::twice(lane::sub(lane::load(middle + x), lane::load(middle + x + 2))));
+
+                // sobel_v: (1, 2, 1) row weights on the difference of the outer rows
+                const auto gy = lane::add(
+                    lane::add(lane::sub(top_left, bottom_left), lane::sub(top_right, bottom_right)),
+                    lane::twice(lane::sub(lane::load(top + x + 1), lane::load(bottom + x + 1))));
+
+                lane::template store_magnitude<Mode>(output_row + x, gx, gy);
+            }
+
+            // Remaining columns go through the same vector code on a zero padded copy, which keeps them bit identical
+            if (x < cols)
+            {
+                using accumulator = scalar_accumulator<T>;
+                using gradient = typename lane::gradient;
+                alignas(64) gradient gx[lanes] = {};
+                alignas(64) gradient gy[lanes] = {};
+                alignas(64) T magnitude[lanes] = {};
+                for (int i = 0; x + i < cols; i++)
+                {
+                    const auto c = x + i;
+                    gx[i] = static_cast<gradient>((accumulator(top[c]) - top[c + 2]) + (accumulator(bottom[c]) - bottom[c + 2]) + 2 * (accumulator(middle[c]) - middle[c + 2]));
+                    gy[i] = static_cast<gradient>((accumulator(top[c]) - bottom[c]) + (accumulator(top[c + 2]) - bottom[c + 2]) + 2 * (accumulator(top[c + 1]) - bottom[c + 1]));
+                }
+                lane::template store_magnitude<Mode>(magnitude, lane::load_gradient(gx), lane::load_gradient(gy));
+                std::memcpy(output_row + x, magnitude, static_cast<std::size_t>(cols - x) * sizeof(T));
+            }
+        }
+    }
+
+    template <typename Ops, typename T>
+    void sobel(const T* input, std::ptrdiff_t input_stride, T* output, std::ptrdiff_t output_stride, int rows, int cols, magnitude_mode magnitude)
+    {
+        lib::internal::dispatch_magnitude(magnitude, [&](auto mode)
+            {
+                sobel_rows<Ops, T, decltype(mode)::value>(input, input_stride, output, output_stride, rows, cols);
+            });
+    }
+
+    template <typename Ops, typename T, magnitude_mode Mode>
+    void roberts_rows(const T* input, std::ptrdiff_t input_stride, T* output, std::ptrdiff_t output_stride, int rows, int cols)
+    {
+        using lane = internal::lane<Ops, T>;
+        constexpr int lanes = lane::lanes;
+
+        for (int y = 0; y < rows; y++)
+        {
+            const T* top = input + y * input_stride;
+            const T* bottom = top + input_stride;
+            T* output_row = output + y * output_stride;
+
+            int x = 0;
+            for (; x + lanes <= cols; x += lanes)
+            {
+                // roberts_h and roberts_v: the two diagonal differences of the 2x2 window
+                const auto gx = lane::sub(lane::load(top + x), lane::load(bottom + x + 1));
+                const auto gy = lane::sub(lane::load(top + x + 1), lane::load(bottom + x));
+                lane::template store_magnitude<Mode>(output_row + x, gx, gy);
+            }
+
+            // Remaining columns go through the same vector code on a zero padded copy, which keeps them bit identical
+            if (x < cols)
+            {
+                using accumulator = scalar_accumulator<T>;
+                using gradient = typename lane::gradient;
+                alignas(64) gradient gx[lanes] = {};
+                alignas(64) gradient gy[lanes] = {};
+                alignas(64) T magnitude[lanes] = {};
+                for (int i = 0; x + i < cols; i++)
+                {
+                    const auto c = x + i;
+                    gx[i] = static_cast<gradient>(accumulator(top[c]) - bottom[c + 1]);
+                    gy[i] = static_cast<gradient>(accumulator(top[c + 1]) - bottom[c]);
+                }
+                lane::template store_magnitude<Mode>(magnitude, lane::load_gradient(gx), lane::load_gradient(gy));
+                std::memcpy(output_row + x, magnitude, static_cast<std::size_t>(cols - x) * sizeof(T));
+            }
+        }
+    }
+
+    template <typename Ops, typename T>
+    void roberts(const T* input, std::ptrdiff_t input_stride, T* output, std::ptrdiff_t output_stride, int rows, int cols, magnitude_mode magnitude)
+    {
+        lib::internal::dispatch_magnitude(magnitude, [&](auto mode)
+            {
+                roberts_rows<Ops, T, decltype(mode)::value>(input, input_stride, output, output_stride, rows, cols);
+            });
+    }
+
+    template <typename Ops, typename TOut>
+    void fixed_convolve(const std::uint8_t* input, std::ptrdiff_t input_stride, TOut* output, std::ptrdiff_t output_stride,
+        int rows, int cols, const std::int16_t* kernel, int kernel_rows, int kernel_cols, int shift)
+    {
+        constexpr int lanes = Ops::lanes16;
+        const auto rounding = static_cast<std::int16_t>(shift > 0 ? 1 << (shift - 1) : 0);
+
+        for (int y = 0; y < rows; y++)
+        {
+            const std::uint8_t* input_row = input + y * input_stride;
+            TOut* output_row = output + y * output_stride;
+
+            int x = 0;
+            for (; x + lanes <= cols; x += lanes)
+            {
+                auto accumulator = Ops::set1_epi16(rounding);
+                for (int r = 0; r < kernel_rows; r++)
+                {
+                    const std::uint8_t* tap = input_row + r * input_stride + x;
+                    const std::int16_t* coefficients = kernel + r * kernel_cols;
+                    for (int c = 0; c < kernel_cols; c++)
+                        accumulator = Ops::add_epi16(accumulator, Ops::mullo_epi16(Ops::load_u8_epi16(tap + c), Ops::set1_epi16(coefficients[c])));
+                }
+                accumulator = Ops::sra_epi16(accumulator, shift);
+
+                if constexpr (std::is_same_v<TOut, std::uint8_t>)
+                    Ops::store_epi16_u8_saturate(output_row + x, accumulator);
+                else
+                    Ops::storeu_epi16(output_row + x, accumulator);
+            }
+
+            for (; x < cols; x++)
+            {
+                auto accumulator = static_cast<std::int32_t>(rounding);
+                for (int r = 0; r < kernel_rows; r++)
+                    for (int c = 0; c < kernel_cols; c++)
+                        accumulator += input_row[r * input_stride + x + c] * kernel[r * kernel_cols + c];
+                accumulator >>= shift;
+                output_row[x] = static_cast<TOut>(std::clamp<std::int32_t>(accumulator, std::numeric_limits<TOut>::lowest(), std::numeric_limits<TOut>::max()));
+            }
+        }
+    }
+
+    template <typename Ops>
+    constexpr kernel_table make_kernel_table(simd_level level)
+    {
+        return kernel_table{
+            level,
+            &convolve<Ops, float>,
+            &convolve<Ops, std::int32_t>,
+            &convolve<Ops, std::uint8_t>,
+            &sobel<Ops, float>,
+            &sobel<Ops, std::int32_t>,
+            &sobel<Ops, std::uint8_t>,
+            &roberts<Ops, float>,
+            &roberts<Ops, std::int32_t>,
+            &roberts<Ops, std::uint8_t>,
+            &fixed_convolve<Ops, std::uint8_t>,
+            &fixed_convolve<Ops, std::int16_t>
+        };
+    }
+}
@@ -0,0 +1,86 @@
+#include "simd_kernels.h"
+
+#if defined(LIB_ARCH_X86)
+#include <smmintrin.h>
+
+namespace lib::simd::internal
+{
+    struct sse41_ops
+    {
+        using vf = __m128;
+        using vi = __m128i;
+        static constexpr int lanes = 4;
+
+        static vf zero_ps() { return _mm_setzero_ps(); }
+        static vf set1_ps(float value) { return _mm_set1_ps(value); }
+        static vf loadu_ps(const float* input) { return _mm_loadu_ps(input); }
+        static void storeu_ps(float* output, vf value) { _mm_storeu_ps(output, value); }
+        static vf add_ps(vf a, vf b) { return _mm_add_ps(a, b); }
+        static vf sub_ps(vf a, vf b) { return _mm_sub_ps(a, b); }
+        static vf mul_ps(vf a, vf b) { return _mm_mul_ps(a, b); }
+        static vf fmadd_ps(vf a, vf b, vf c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+        static vf min_ps(vf a, vf b) { return _mm_min_ps(a, b); }
+        static vf max_ps(vf a, vf b) { return _mm_max_ps(a, b); }
+        static vf sqrt_ps(vf a) { return _mm_sqrt_ps(a); }
+
+        static vi zero_si() { return _mm_setzero_si128(); }
+        static vi set1_epi32(std::int32_t value) { return _mm_set1_epi32(value); }
+        static vi loadu_epi32(const std::int32_t* input) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(input)); }
+        static void storeu_epi32(std::int32_t* output, vi value) { _mm_storeu_si128(reinterpret_cast<__m128i*>(output), value); }
+        static vi add_epi32(vi a, vi b) { return _mm_add_epi32(a, b); }
+        static vi sub_epi32(vi a, vi b) { return _mm_sub_epi32(a, b); }
+        static vi mullo_epi32(vi a, vi b) { return _mm_mullo_epi32(a, b); }
+        template <int N> static vi slli_epi32(vi a) { return _mm_slli_epi32(a, N); }
+
+
+
+        static vf cvtepi32_ps(vi a) { return _mm_cvtepi32_ps(a); }
+
+        static vi cvttps_epi32_saturate(vf a)
+        {
+            // Overflowing lanes convert to INT32_MIN, flipping all bits turns them into INT32_MAX
+            const auto converted = _mm_cvttps_epi32(a);
+            return _mm_xor_si128(converted, _mm_cmpeq_epi32(converted, _mm_set1_epi32(std::numeric_limits<std::int32_t>::min())));
+        }
+
+        using vs = __m128i;
+        static constexpr int lanes16 = 8;
+
+        static vs set1_epi16(std::int16_t value) { return _mm_set1_epi16(value); }
+        static vs add_epi16(vs a, vs b) { return _mm_add_epi16(a, b); }
+        static vs sub_epi16(vs a, vs b) { return _mm_sub_epi16(a, b); }
+        static vs mullo_epi16(vs a, vs b) { return _mm_mullo_epi16(a, b); }
+        static vs sra_epi16(vs a, int shift) { return _mm_sra_epi16(a, _mm_cvtsi32_si128(shift)); }
+        template <int N> static vs srli_epi16(vs a) { return _mm_srli_epi16(a, N); }
+        static vs abs_epi16(vs a) { return _mm_abs_epi16(a); }
+        static vs min_epi16(vs a, vs b) { return _mm_min_epi16(a, b); }
+        static vs max_epi16(vs a, vs b) { return _mm_max_epi16(a, b); }
+
+        static vs load_u8_epi16(const std::uint8_t* input)
+        {
+            return _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(input)));
+        }
+
+        static vs loadu_epi16(const std::int16_t* input) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(input)); }
+        static void storeu_epi16(std::int16_t* output, vs value) { _mm_storeu_si128(reinterpret_cast<__m128i*>(output), value); }
+
+        static void store_epi16_u8(std::uint8_t* output, vs value)
+        {
+            // Masking to the low byte first keeps the saturating pack from clamping
+            const auto low_bytes = _mm_and_si128(value, _mm_set1_epi16(0xff));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(output), _mm_packus_epi16(low_bytes, low_bytes));
+        }
+
+        static void store_epi16_u8_saturate(std::uint8_t* output, vs value)
+        {
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(output), _mm_packus_epi16(value, value));
+        }
+
+        static vi cvtepi16_epi32_low(vs a) { return _mm_cvtepi16_epi32(a); }
+        static vi cvtepi16_epi32_high(vs a) { return _mm_cvtepi16_epi32(_mm_srli_si128(a, 8)); }
+        static vs packs_epi32_epi16(vi low, vi high) { return _mm_packs_epi32(low, high); }
+    };
+
+    extern const kernel_table sse41_kernels = make_kernel_table<sse41_ops>(simd_level::SSE41);
+}
+#endif
@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include <core/core.h>
+#include <cstdint>
+#include <future>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+TEST(allocator, malloc_allocator_backs_a_vector)
+{
+    std::vector<int, lib::malloc_allocator<int>> values(100);
+    std::iota(values.begin(), values.end(), 0);
+
+    ASSERT_EQ(4950, std::accumulate(values.begin(), values.end(), 0));
+    ASSERT_TRUE(lib::malloc_allocator<int>() == lib::malloc_allocator<float>());
+    ASSERT_FALSE(lib::malloc_allocator<int>() != lib::malloc_allocator<float>());
+}
+
+TEST(buffer_pool, freed_blocks_are_handed_out_again)
+{
+    lib::buffer_pool pool;
+    auto* first = pool.allocate(1000);
+    ASSERT_EQ(0u, reinterpret_cast<std::uintptr_t>(first) % lib::row_alignment);
+    pool.deallocate(first, 1000);
+
+    // 1000 and 1020 bytes share a size class, 2000 bytes does not
+    auto* second = pool.allocate(1020);
+    ASSERT_EQ(first, second);
+    auto* third = pool.allocate(2000);
+    ASSERT_NE(first, third);
+
+    pool.deallocate(second, 1020);
+    pool.deallocate(third, 2000);
+}
+
+TEST(buffer_pool, blocks_beyond_the_thread_cache_go_to_the_shared_lists)
+{
+    lib::buffer_pool pool;
+    std::vector<void*> blocks;
+    for (int i = 0; i < 10; i++)
+        blocks.push_back(pool.allocate(4096));
+    for (auto* block : blocks)
+        pool.deallocate(block, 4096);
+    ASSERT_LT(0u, pool.cached_bytes());
+
+    pool.trim();
+    ASSERT_EQ(0u, pool.cached_bytes());
+}
+
+TEST(buffer_pool, max_cached_bytes_bounds_the_shared_lists)
+{
+    lib::buffer_pool pool(8192);
+    std::vector<void*> blocks;
+    for (int i = 0; i < 20; i++)
+        blocks.push_back(pool.allocate(4096));
+    for (auto* block : blocks)
+        pool.deallocate(block, 4096);
+
+    ASSERT_LE(pool.cached_bytes(), 8192u);
+}
+
+TEST(buffer_pool, large_blocks_go_straight_to_the_shared_lists)
+{
+    lib::buffer_pool pool(std::size_t{ 1 } << 20);
+    auto* block = pool.allocate(std::size_t{ 1 } << 20);
+    pool.deallocate(block, std::size_t{ 1 } << 20);
+    ASSERT_EQ(std::size_t{ 1 } << 20, pool.cached_bytes());
+
+    // Beyond max_cached_bytes, even though no thread cache holds a block of the class
+    auto* larger = pool.allocate(std::size_t{ 2 } << 20);
+    pool.deallocate(larger, std::size_t{ 2 } << 20);
+    ASSERT_LE(pool.cached_bytes(), std::size_t{ 1 } << 20);
+}
+
+TEST(buffer_pool, trim_reaches_the_caches_of_other_threads)
+{
+    lib::buffer_pool pool;
+    std::promise<void> cached, trimmed;
+    std::thread worker([&]
+        {
+            pool.deallocate(pool.allocate(4096), 4096);
+            cached.set_value();
+            trimmed.get_future().wait();
+        });
+
+    cached.get_future().wait();
+    pool.trim();
+    trimmed.set_value();
+    worker.join();
+
+    // The worker exits after the trim, so its cached block is freed rather than moved to the shared lists
+    ASSERT_EQ(0u, pool.cached_bytes());
+}
+
+TEST(buffer_pool, threads_allocate_and_free_concurrently)
+{
+    lib::buffer_pool pool;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&pool, t]
+            {
+                for (int i = 0; i < 1000; i++)
+                {
+                    const auto bytes = static_cast<std::size_t>(64 + (i % 7) * 500);
+                    auto* block = static_cast<std::uint8_t*>(pool.allocate(bytes));
+                    std::fill(block, block + bytes, static_cast<std::uint8_t>(t));
+                    ASSERT_EQ(t, block[bytes - 1]);
+                    pool.deallocate(block, bytes);
+                }
+            });
+    }
+    for (auto& thread : threads)
+        thread.join();
+}
+
+TEST(pooled_array2d, frames_reuse_the_elements_of_freed_frames)
+{
+    lib::buffer_pool pool;
+    const float* previous = nullptr;
+    for (int frame = 0; frame < 3; frame++)
+    {
+        auto image = lib::make_pooled_array2d<float>(48, 64, pool);
+        std::fill(image.begin(), image.end(), static_cast<float>(frame));
+        ASSERT_EQ(static_cast<float>(frame), image[47][63]);
+        if (previous != nullptr)
+        {
+            ASSERT_EQ(previous, image.data());
+        }
+        previous = image.data();
+    }
+}
+
+TEST(pooled_array2d, aligned_rows_are_padded_like_array2d)
+{
+    lib::buffer_pool pool;
+    auto image = lib::make_pooled_array2d<float>(5, 17, lib::aligned_rows, pool);
+    auto expected = lib::array2d<float>(5, 17, lib::aligned_rows);
+    ASSERT_EQ(expected.stride(), image.stride());
+
+    std::iota(image.begin(), image.end(), 0.f);
+    std::iota(expected.begin(), expected.end(), 0.f);
+    ASSERT_TRUE(image == expected);
+    for (int row = 0; row < image.rows(); row++)
+        ASSERT_EQ(0u, reinterpret_cast<std::uintptr_t>(&image[row][0]) % lib::row_alignment);
+}
+
+TEST(pooled_array2d, arrays_may_outlive_their_pool)
+{
+    auto pool = std::make_unique<lib::buffer_pool>();
+    auto image = lib::make_pooled_array2d<std::uint8_t>(16, 16, *pool);
+    pool.reset();
+
+    std::fill(image.begin(), image.end(), std::uint8_t{ 7 });
+    ASSERT_EQ(7, image[15][15]);
+}
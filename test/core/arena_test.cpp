@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+#include <core/core.h>
+#include <cstdint>
+#include <numeric>
+
+TEST(arena, allocations_follow_each_other_in_the_reservation)
+{
+    lib::arena memory(4096);
+    auto* first = static_cast<std::uint8_t*>(memory.allocate(100));
+    auto* second = static_cast<std::uint8_t*>(memory.allocate(8, 8));
+    auto* third = static_cast<std::uint8_t*>(memory.allocate(64));
+
+    ASSERT_EQ(0u, reinterpret_cast<std::uintptr_t>(first) % lib::row_alignment);
+    ASSERT_EQ(first + 128, second);
+    ASSERT_EQ(first + 192, third);
+    ASSERT_EQ(256u, memory.used());
+}
+
+TEST(arena, reset_hands_out_the_same_memory_again)
+{
+    lib::arena memory(4096);
+    auto* first = memory.allocate(1000);
+    memory.reset();
+
+    ASSERT_EQ(0u, memory.used());
+    ASSERT_EQ(first, memory.allocate(1000));
+}
+
+TEST(arena, overflow_is_folded_into_the_reservation_on_reset)
+{
+    lib::arena memory(256);
+    (void)memory.allocate(200);
+    auto* overflow = memory.allocate(1000);
+    ASSERT_NE(nullptr, overflow);
+    ASSERT_EQ(1280u, memory.used());
+
+    memory.reset();
+    ASSERT_EQ(1280u, memory.capacity());
+    auto* first = static_cast<std::uint8_t*>(memory.allocate(200));
+    ASSERT_EQ(first + 256, memory.allocate(1000));
+}
+
+TEST(arena, arrays_are_views_into_the_arena)
+{
+    lib::arena memory(lib::arena::array_bytes<float>(3, 5) + lib::arena::array_bytes<int>(4, 7, lib::aligned_rows));
+    auto floats = memory.make_array2d<float>(3, 5);
+    auto ints = memory.make_array2d<int>(4, 7, lib::aligned_rows);
+    ASSERT_EQ(memory.capacity(), memory.used());
+
+    std::iota(floats.begin(), floats.end(), 0.f);
+    std::iota(ints.begin(), ints.end(), 0);
+    ASSERT_EQ(14.f, floats[2][4]);
+    ASSERT_EQ(27, ints[3][6]);
+    ASSERT_EQ(lib::internal::aligned_stride<int>(7), ints.stride());
+    ASSERT_EQ(0u, reinterpret_cast<std::uintptr_t>(ints.data()) % lib::row_alignment);
+}
@@ -2,6 +2,9 @@
 #include <memory>
 #include <core/core.h>
 #include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <type_traits>
 
 TEST(array2d, indexing_returns_the_correct_value)
 {
@@ -25,4 +28,92 @@ TEST(array2d, iterator_works)
         counter++;
     }
     ASSERT_EQ(64, counter);
-}
\ No newline at end of file
+}
+TEST(array2d, aligned_rows_start_on_the_row_alignment)
+{
+    lib::array2d<float> array(5, 33, lib::aligned_rows);
+
+    ASSERT_EQ(48, array.stride());
+    ASSERT_FALSE(array.is_contiguous());
+    for (int row = 0; row < array.rows(); row++)
+        ASSERT_EQ(0u, reinterpret_cast<std::uintptr_t>(array.data() + row * array.stride()) % lib::row_alignment);
+
+    // A 4 KiB row gets one more cache line, so vertical neighbours do not alias
+    ASSERT_EQ(4096 + 64, (lib::array2d<std::uint8_t>(2, 4096, lib::aligned_rows).stride()));
+    ASSERT_EQ(64, (lib::array2d<std::uint8_t>(2, 64, lib::aligned_rows).stride()));
+}
+
+TEST(array2d, iterators_and_indexing_skip_the_row_padding)
+{
+    auto data = std::make_unique<int[]>(3 * 6);
+    std::fill(&data[0], &data[18], -1);
+    lib::array2d<int> array(3, 4, std::move(data), 6);
+    std::iota(array.begin(), array.end(), 0);
+
+    ASSERT_EQ(6, array.stride());
+    ASSERT_EQ(12, std::distance(array.begin(), array.end()));
+    ASSERT_EQ(5, array[1][1]);
+    ASSERT_EQ(-1, array.data()[4]);
+    ASSERT_EQ(11, array.data()[2 * 6 + 3]);
+
+    auto it = array.begin() + 7;
+    ASSERT_EQ(7, *it);
+    ASSERT_EQ(3, *(it - 4));
+    ASSERT_EQ(4, *--(it - 2));
+    ASSERT_EQ(7, it - array.begin());
+    ASSERT_EQ(4, array.cbegin()[4]);
+
+    auto counter = 0;
+    for (const auto& value : array)
+        ASSERT_EQ(counter++, value);
+    ASSERT_EQ(12, counter);
+}
+
+TEST(array2d, subview_shares_the_elements_of_its_array)
+{
+    lib::array2d<int> array(6, 7);
+    std::iota(array.begin(), array.end(), 0);
+
+    auto view = array.subview(1, 2, 3, 4);
+    ASSERT_EQ(3, view.rows());
+    ASSERT_EQ(4, view.cols());
+    ASSERT_EQ(7, view.stride());
+    ASSERT_EQ(9, view[0][0]);
+    ASSERT_EQ(26, view[2][3]);
+    ASSERT_EQ(12, std::distance(view.begin(), view.end()));
+
+    view[1][1] = -1;
+    ASSERT_EQ(-1, array[2][3]);
+
+    auto nested = view.subview(1, 1, 2, 2);
+    ASSERT_EQ(-1, nested[0][0]);
+    ASSERT_EQ(25, nested[1][1]);
+
+
+    int buffer[] = { 1, 2, 0, 3, 4, 0 };
+    auto external = lib::make_array2d_view(buffer, 2, 2, 3);
+    ASSERT_EQ(4, external[1][1]);
+    ASSERT_EQ(10, std::accumulate(external.begin(), external.end(), 0));
+}
+
+TEST(array2d, views_of_const_arrays_only_read)
+{
+    lib::array2d<int> array(4, 5);
+    std::iota(array.begin(), array.end(), 0);
+
+    const auto& constant = array;
+    auto view = constant.subview(1, 1, 2, 3);
+    static_assert(std::is_same_v<decltype(view), lib::array2d_const_view<int>>);
+    static_assert(std::is_same_v<decltype(view.data()), const int*>);
+    static_assert(std::is_same_v<decltype(*view.begin()), const int&>);
+    static_assert(std::is_same_v<decltype(view[0][0]), const int&>);
+    static_assert(std::is_same_v<decltype(view.subview(0, 0, 1, 1)), lib::array2d_const_view<int>>);
+    ASSERT_EQ(6, view[0][0]);
+    ASSERT_EQ(13, view[1][2]);
+    ASSERT_TRUE(constant.view() == array);
+
+    const int buffer[] = { 1, 2, 0, 3, 4, 0 };
+    auto external = lib::make_array2d_view(buffer, 2, 2, 3);
+    static_assert(std::is_same_v<decltype(external), lib::array2d_const_view<int>>);
+    ASSERT_EQ(10, std::accumulate(external.begin(), external.end(), 0));
+}
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include <core/core.h>
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <numeric>
+#include <string>
+#include <system_error>
+
+TEST(mapped_array2d, anonymous_arrays_start_zeroed)
+{
+    auto image = lib::make_mapped_array2d<float>(512, 700);
+    ASSERT_TRUE(std::all_of(image.begin(), image.end(), [](float value) { return value == 0.f; }));
+
+    std::iota(image.begin(), image.end(), 0.f);
+    ASSERT_EQ(511.f * 700 + 699, image[511][699]);
+}
+
+TEST(mapped_array2d, arrays_can_hold_more_than_2_31_elements)
+{
+    // 2.5e9 elements, only the pages written below take memory
+    auto image = lib::make_mapped_array2d<std::uint8_t>(50000, 50000, lib::access_pattern::Random);
+    ASSERT_EQ(std::size_t{ 2500000000 }, image.size());
+    ASSERT_EQ(static_cast<std::ptrdiff_t>(image.size()), std::distance(image.begin(), image.end()));
+
+    image[49999][49999] = 7;
+    image[45000][1] = 3;
+    ASSERT_EQ(7, *(image.end() - 1));
+    ASSERT_EQ(3, image.data()[std::size_t{ 45000 } * 50000 + 1]);
+
+    const auto& constant = image;
+    auto corner = constant.subview(49998, 49997, 2, 3);
+    ASSERT_EQ(7, corner[1][2]);
+    ASSERT_EQ(7, *std::max_element(corner.begin(), corner.end()));
+}
+
+TEST(mapped_array2d, created_files_hold_the_rows)
+{
+    const auto path = std::string("./TestResults/mapped_array2d_rows.raw");
+    {
+        auto image = lib::map_array2d<std::uint16_t>(path, 300, 200, lib::map_mode::Create);
+        std::iota(image.begin(), image.end(), std::uint16_t{ 0 });
+    }
+
+    auto image = lib::map_array2d<std::uint16_t>(path, 300, 200, lib::map_mode::Read);
+    auto expected = lib::array2d<std::uint16_t>(300, 200);
+    std::iota(expected.begin(), expected.end(), std::uint16_t{ 0 });
+    ASSERT_TRUE(image == expected);
+}
+
+TEST(mapped_array2d, only_read_write_mappings_change_the_file)
+{
+    const auto path = std::string("./TestResults/mapped_array2d_modes.raw");
+    {
+        auto image = lib::map_array2d<std::uint8_t>(path, 64, 64, lib::map_mode::Create);
+        std::fill(image.begin(), image.end(), std::uint8_t{ 1 });
+    }
+    {
+        auto image = lib::map_array2d<std::uint8_t>(path, 64, 64, lib::map_mode::Read);
+        image[10][10] = 2;
+        ASSERT_EQ(2, image[10][10]);
+    }
+    {
+        auto image = lib::map_array2d<std::uint8_t>(path, 64, 64, lib::map_mode::ReadWrite);
+        ASSERT_EQ(1, image[10][10]);
+        image[20][20] = 3;
+    }
+
+    auto image = lib::map_array2d<std::uint8_t>(path, 64, 64, lib::map_mode::Read, lib::access_pattern::Random);
+    ASSERT_EQ(1, image[10][10]);
+    ASSERT_EQ(3, image[20][20]);
+}
+
+TEST(mapped_array2d, files_smaller_than_the_image_are_rejected)
+{
+    const auto path = std::string("./TestResults/mapped_array2d_small.raw");
+    (void)lib::map_array2d<std::uint8_t>(path, 10, 10, lib::map_mode::Create);
+
+    ASSERT_THROW((void)lib::map_array2d<std::uint8_t>(path, 10, 11, lib::map_mode::Read), std::system_error);
+    ASSERT_THROW((void)lib::map_array2d<std::uint8_t>("./TestResults/missing.raw", 10, 10, lib::map_mode::ReadWrite), std::system_error);
+}
+
+TEST(mapped_array2d, rows_can_be_advised_on_any_array)
+{
+    auto heap = lib::array2d<float>(100, 100, lib::aligned_rows);
+    auto mapped = lib::make_mapped_array2d<float>(100, 100, lib::access_pattern::Normal);
+    lib::advise_rows(heap, 10, 20, lib::access_pattern::WillNeed);
+    lib::advise_rows(mapped, 0, 100, lib::access_pattern::Sequential);
+    lib::advise_rows(mapped, 50, 50, lib::access_pattern::Random);
+
+    std::fill(mapped.begin(), mapped.end(), 1.f);
+    ASSERT_EQ(10000.f, std::accumulate(mapped.begin(), mapped.end(), 0.f));
+}
@@ -116,3 +116,20 @@ TEST(sliding_window_view, supports_range_based_for)
         expected_value_at_position++;
     }
 }
+
+TEST(sliding_window_view, steps_over_the_row_padding)
+{
+    lib::array2d<int> array(8, 8, lib::aligned_rows);
+    std::iota(array.begin(), array.end(), 0);
+
+    auto view = lib::make_sliding_window_view<3, 3>(array);
+
+    auto expect = std::vector<int>
+    {
+        21, 22, 23,
+        29, 30, 31,
+        37, 38, 39
+    };
+
+    ASSERT_TRUE((test_helper::window_matches <3, 3, lib::array2d<int>>(expect, view[17])));
+}
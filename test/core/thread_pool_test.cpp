@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include <core/core.h>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+TEST(thread_pool, parallel_for_visits_every_index_once)
+{
+    lib::thread_pool pool(4);
+    std::vector<std::atomic<int>> visits(1000);
+
+    pool.parallel_for(1000, 7, [&](int begin, int end)
+        {
+            for (int i = begin; i < end; i++)
+                visits[i]++;
+        });
+
+    for (const auto& count : visits)
+        ASSERT_EQ(1, count);
+}
+
+TEST(thread_pool, parallel_for_respects_grain)
+{
+    lib::thread_pool pool(4);
+    std::atomic<int> chunks{ 0 };
+
+    pool.parallel_for(100, 40, [&](int begin, int end)
+        {
+            chunks++;
+            ASSERT_TRUE(end - begin >= 20);
+        });
+
+    ASSERT_LE(chunks, 3);
+}
+
+TEST(thread_pool, empty_pool_runs_on_calling_thread)
+{
+    lib::thread_pool pool(0);
+    const auto caller = std::this_thread::get_id();
+
+    pool.parallel_for(10, 1, [&](int, int)
+        {
+            ASSERT_EQ(caller, std::this_thread::get_id());
+        });
+}
+
+TEST(thread_pool, nested_parallel_for_completes)
+{
+    lib::thread_pool pool(2);
+    std::atomic<int> sum{ 0 };
+
+    pool.parallel_for(8, 1, [&](int begin, int end)
+        {
+            for (int i = begin; i < end; i++)
+            {
+                pool.parallel_for(8, 1, [&](int inner_begin, int inner_end)
+                    {
+                        sum += inner_end - inner_begin;
+                    });
+            }
+        });
+
+    ASSERT_EQ(64, sum);
+}
+
+TEST(thread_pool, parallel_for_rethrows_exceptions)
+{
+    lib::thread_pool pool(4);
+
+    ASSERT_THROW(pool.parallel_for(100, 1, [](int begin, int)
+        {
+            if (begin == 0)
+                throw std::runtime_error("failed");
+        }), std::runtime_error);
+}
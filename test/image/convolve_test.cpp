@@ -2,7 +2,10 @@
 #include <gmock/gmock.h>
 #include <image/image.h>
 #include <core/core.h>
+#include <cstdint>
+#include <fstream>
 #include <numeric>
+#include <string>
 
 #include <vector>
 
@@ -55,3 +58,474 @@ TEST(convolve, convolution_works_with_custom_kernel)
 
     ASSERT_EQ(45, result[0][0]);
 }
+
+namespace test_helper
+{
+    // Reference implementation of the valid-region correlation used by lib::convolve
+    template<std::size_t Height, std::size_t Width, typename T>
+    lib::array2d<T> naive_convolve(lib::array2d<T>& input, const lib::kernel<Height, Width, T>& kernel)
+    {
+        lib::array2d<T> result(input.rows() - (Height - 1), input.cols() - (Width - 1));
+        for (int j = 0; j < result.rows(); j++)
+            for (int i = 0; i < result.cols(); i++)
+            {
+                T sum{};
+                for (int r = 0; r < static_cast<int>(Height); r++)
+                    for (int c = 0; c < static_cast<int>(Width); c++)
+                        sum += input[j + r][i + c] * kernel.values[r * Width + c];
+                result[j][i] = sum;
+            }
+        return result;
+    }
+}
+
+TEST(convolve, detects_separable_kernels_at_compile_time)
+{
+    static_assert(lib::is_separable(lib::kernels::gaussian_blur<int>));
+    static_assert(lib::is_separable(lib::kernels::sobel_h<int>));
+    static_assert(lib::is_separable(lib::kernels::sobel_v<float>));
+    static_assert(!lib::is_separable(lib::kernels::sharpen<int>));
+
+    constexpr auto factors = lib::separate(lib::kernels::gaussian_blur<int>);
+    static_assert(factors.column[0] == 1 && factors.column[1] == 2 && factors.column[2] == 1);
+    static_assert(factors.row[0] == 1 && factors.row[1] == 2 && factors.row[2] == 1);
+}
+
+TEST(convolve, generates_derivative_kernels_at_compile_time)
+{
+    static_assert(lib::kernels::sobel_h_5<int>.values[0] == 1 && lib::kernels::sobel_h_5<int>.values[24] == -1);
+    static_assert(lib::is_separable(lib::kernels::sobel_h_7<int>));
+    static_assert(lib::is_separable(lib::kernels::scharr_v<float>));
+
+    ASSERT_EQ(lib::kernels::sobel_h<int>.values, (lib::make_kernel(lib::make_sobel_h_factors<3, int>()).values));
+    ASSERT_EQ(lib::kernels::sobel_v<int>.values, (lib::make_kernel(lib::make_sobel_v_factors<3, int>()).values));
+
+    constexpr auto sobel_5 = lib::make_sobel_h_factors<5, int>();
+    ASSERT_EQ((std::array<int, 5>{ 1, 4, 6, 4, 1 }), sobel_5.column);
+    ASSERT_EQ((std::array<int, 5>{ 1, 2, 0, -2, -1 }), sobel_5.row);
+    ASSERT_EQ((std::array<int, 7>{ 1, 4, 5, 0, -5, -4, -1 }), (lib::make_sobel_v_factors<7, int>().column));
+    ASSERT_EQ((std::array<int, 9>{ 3, 0, -3, 10, 0, -10, 3, 0, -3 }), lib::kernels::scharr_h<int>.values);
+
+    // The separable factors and the dense kernel give the same result
+    lib::array2d<int> array(31, 29);
+    std::iota(array.begin(), array.end(), -400);
+    for (auto& value : array)
+        value = value * value % 97;
+    ASSERT_TRUE(lib::convolve(array, lib::make_sobel_v_factors<7, int>()) == test_helper::naive_convolve(array, lib::kernels::sobel_v_7<int>));
+}
+
+TEST(convolve, separate_reconstructs_kernel)
+{
+    constexpr auto sobel_factors = lib::separate(lib::kernels::sobel_h<int>);
+    ASSERT_EQ(lib::kernels::sobel_h<int>.values, lib::make_kernel(sobel_factors).values);
+
+    constexpr auto gaussian_factors = lib::separate(lib::kernels::gaussian_blur<float>);
+    auto reconstructed = lib::make_kernel(gaussian_factors);
+    for (std::size_t i = 0; i < reconstructed.values.size(); i++)
+        ASSERT_FLOAT_EQ(lib::kernels::gaussian_blur<float>.values[i], reconstructed.values[i]);
+}
+
+TEST(convolve, separable_convolution_matches_full_convolution)
+{
+    lib::array2d<int> array(16, 21);
+    std::iota(array.begin(), array.end(), -100);
+
+    auto factors = lib::make_separable_kernel<5, 7, int>({ 1, 4, 6, 4, 1 }, { -1, 2, 0, 3, 1, -2, 5 });
+    auto expected = test_helper::naive_convolve(array, lib::make_kernel(factors));
+
+    ASSERT_TRUE(expected == lib::convolve(array, factors));
+    ASSERT_TRUE(expected == lib::convolve(array, lib::make_kernel(factors)));
+}
+
+TEST(convolve, non_separable_kernel_uses_full_convolution)
+{
+    lib::array2d<int> array(9, 11);
+    std::iota(array.begin(), array.end(), 0);
+
+    auto expected = test_helper::naive_convolve(array, lib::kernels::sharpen<int>);
+
+    ASSERT_TRUE(expected == lib::convolve(array, lib::kernels::sharpen<int>));
+}
+
+TEST(convolve, parallel_convolution_matches_sequential)
+{
+    lib::array2d<int> array(203, 67);
+    std::iota(array.begin(), array.end(), -5000);
+
+    lib::thread_pool pool(3);
+    auto policy = lib::execution::par.on(pool).with_grain(5);
+
+    ASSERT_TRUE(lib::convolve(array, lib::kernels::sharpen<int>) == lib::convolve(policy, array, lib::kernels::sharpen<int>));
+    ASSERT_TRUE(lib::convolve(array, lib::kernels::gaussian_blur<int>) == lib::convolve(policy, array, lib::kernels::gaussian_blur<int>));
+    ASSERT_TRUE(lib::convolve(array, lib::kernels::sobel_v<int>) == lib::convolve(lib::execution::par, array, lib::kernels::sobel_v<int>));
+}
+
+TEST(convolve, tiled_convolution_matches_sequential)
+{
+    lib::array2d<int> array(97, 131);
+    std::iota(array.begin(), array.end(), -7000);
+
+    auto factors = lib::make_separable_kernel<5, 7, int>({ 1, 4, 6, 4, 1 }, { -1, 2, 0, 3, 1, -2, 5 });
+    auto small_tiles = lib::execution::tiled.with_tile(13, 17);
+
+    ASSERT_TRUE(lib::convolve(array, lib::kernels::sharpen<int>) == lib::convolve(small_tiles, array, lib::kernels::sharpen<int>));
+    ASSERT_TRUE(lib::convolve(array, factors) == lib::convolve(small_tiles, array, factors));
+    ASSERT_TRUE(lib::convolve(array, factors) == lib::convolve(lib::execution::tiled, array, factors));
+    ASSERT_TRUE(lib::convolve(array, lib::kernels::gaussian_blur<int>) == lib::convolve(lib::execution::tiled, array, lib::kernels::gaussian_blur<int>));
+}
+
+TEST(convolve, convolve_into_matches_allocating_convolution)
+{
+    lib::array2d<int> array(61, 47);
+    std::iota(array.begin(), array.end(), -1500);
+
+    // The same output is written twice, the second call must not depend on what the first one left behind
+    lib::array2d<int> output(59, 45);
+    for (int repeat = 0; repeat < 2; repeat++)
+    {
+        lib::convolve_into(array, lib::kernels::sharpen<int>, output);
+        ASSERT_TRUE(lib::convolve(array, lib::kernels::sharpen<int>) == output);
+
+        lib::convolve_into(lib::execution::tiled.with_tile(11, 13), array, lib::kernels::gaussian_blur<int>, output);
+        ASSERT_TRUE(lib::convolve(array, lib::kernels::gaussian_blur<int>) == output);
+
+        lib::convolve_into(array, lib::make_dynamic_kernel(lib::kernels::sharpen<int>), output);
+        ASSERT_TRUE(lib::convolve(array, lib::kernels::sharpen<int>) == output);
+    }
+
+    lib::array2d<int> full_size(61, 47);
+    lib::convolve_into<lib::border::reflect>(lib::execution::par, array, lib::kernels::gaussian_blur<int>, full_size);
+    ASSERT_TRUE(lib::convolve<lib::border::reflect>(array, lib::kernels::gaussian_blur<int>) == full_size);
+}
+
+TEST(convolve, multi_kernel_convolution_matches_single_kernels)
+{
+    lib::array2d<int> array(41, 37);
+    std::iota(array.begin(), array.end(), -800);
+
+    const auto bank = std::array{ lib::kernels::sobel_h<int>, lib::kernels::sobel_v<int>, lib::kernels::sharpen<int> };
+    auto responses = lib::convolve_multi(lib::execution::par.with_grain(4), array, bank);
+    for (std::size_t k = 0; k < bank.size(); k++)
+        ASSERT_TRUE(lib::convolve(array, bank[k]) == responses[k]);
+
+    auto view = lib::make_sliding_window_view<3, 3>(array);
+    auto window = view[100];
+    auto window_responses = lib::convolve_window_multi<3, 3, lib::array2d<int>>(window, lib::kernels::sobel_v<int>, lib::kernels::sharpen<int>);
+    ASSERT_EQ((lib::convolve_window_unrolled<3, 3, lib::array2d<int>>(window, lib::kernels::sobel_v<int>)), window_responses[0]);
+    ASSERT_EQ((lib::convolve_window_unrolled<3, 3, lib::array2d<int>>(window, lib::kernels::sharpen<int>)), window_responses[1]);
+}
+
+namespace test_helper
+{
+    // Copies the input into a buffer extended by the given margins, resolving the outside pixels like the border policy
+    template<typename T, typename Border>
+    lib::array2d<T> pad(const lib::array2d<T>& input, int margin_rows, int margin_cols, const Border& border)
+    {
+        lib::array2d<T> result(input.rows() + 2 * margin_rows, input.cols() + 2 * margin_cols);
+        for (int j = 0; j < result.rows(); j++)
+            for (int i = 0; i < result.cols(); i++)
+                result[j][i] = lib::internal::border_sample(input.data(), input.cols(), input.rows(), input.cols(), j - margin_rows, i - margin_cols, border);
+        return result;
+    }
+
+    template<typename Border>
+    void expect_full_size_convolution(lib::array2d<int>& array, const Border& border)
+    {
+        auto factors = lib::make_separable_kernel<5, 7, int>({ 1, 4, 6, 4, 1 }, { -1, 2, 0, 3, 1, -2, 5 });
+        auto padded = pad(array, 2, 3, border);
+        ASSERT_TRUE(naive_convolve(padded, lib::make_kernel(factors)) == lib::convolve<Border>(array, factors, border));
+
+        auto padded_by_one = pad(array, 1, 1, border);
+        ASSERT_TRUE(naive_convolve(padded_by_one, lib::kernels::sharpen<int>) == lib::convolve<Border>(array, lib::kernels::sharpen<int>, border));
+    }
+}
+
+TEST(convolve, separable_strips_recompute_their_halo_rows)
+{
+    // Rows this wide give strips of the minimum 16 rows on any L2 up to 3 MiB, so every band runs several of them
+    lib::array2d<int> array(45, 24000);
+    std::iota(array.begin(), array.end(), -500000);
+    for (auto& value : array)
+        value %= 251;
+
+    lib::thread_pool pool(3);
+    const auto policy = lib::execution::par.on(pool).with_grain(37);
+    auto factors = lib::make_separable_kernel<5, 7, int>({ 1, 4, 6, 4, 1 }, { -1, 2, 0, 3, 1, -2, 5 });
+    auto expected = test_helper::naive_convolve(array, lib::make_kernel(factors));
+    ASSERT_TRUE(expected == lib::convolve(array, factors));
+    ASSERT_TRUE(expected == lib::convolve(policy, array, factors));
+
+    test_helper::expect_full_size_convolution(array, lib::border::constant{ 7 });
+    test_helper::expect_full_size_convolution(array, lib::border::wrap{});
+    auto padded = test_helper::pad(array, 2, 3, lib::border::reflect{});
+    ASSERT_TRUE(test_helper::naive_convolve(padded, lib::make_kernel(factors)) == lib::convolve<lib::border::reflect>(policy, array, factors));
+}
+
+namespace test_helper
+{
+    // Peak resident memory in KiB since the last reset_peak_memory, or -1 where /proc does not tell
+    long peak_memory_kib()
+    {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line))
+        {
+            if (line.rfind("VmHWM:", 0) == 0)
+                return std::stol(line.substr(6));
+        }
+        return -1;
+    }
+
+    bool reset_peak_memory()
+    {
+        std::ofstream clear_refs("/proc/self/clear_refs");
+        clear_refs << "5";
+        return static_cast<bool>(clear_refs.flush());
+    }
+}
+
+TEST(convolve, separable_convolution_of_a_mapped_image_needs_no_image_sized_buffer)
+{
+    constexpr auto rows = 2048;
+    constexpr auto cols = 8192;
+    auto input = lib::make_mapped_array2d<float>(rows, cols, lib::aligned_rows);
+    auto output = lib::make_mapped_array2d<float>(rows - 4, cols - 4, lib::aligned_rows);
+    ASSERT_EQ(0u, reinterpret_cast<std::uintptr_t>(input.data()) % lib::row_alignment);
+    ASSERT_EQ(lib::internal::aligned_stride<float>(cols), input.stride());
+    for (int col = 0; col < cols; col++)
+        input[1000][col] = 1.f;
+
+    // Untouched input pages read as the shared zero page, so the output is all the convolution itself has to add
+    if (!test_helper::reset_peak_memory() || test_helper::peak_memory_kib() < 0)
+        GTEST_SKIP() << "Peak resident memory is not available";
+    const auto before = test_helper::peak_memory_kib();
+    lib::convolve_into(input, lib::make_separable_kernel<5, 5, float>({ 1, 4, 6, 4, 1 }, { 1, 4, 6, 4, 1 }), output);
+    const auto grown = test_helper::peak_memory_kib() - before;
+
+    const auto output_kib = static_cast<long>(static_cast<std::size_t>(output.rows()) * output.stride() * sizeof(float) / 1024);
+    ASSERT_LT(grown, output_kib + 16 * 1024);
+    ASSERT_EQ(0.f, output[900][100]);
+    ASSERT_EQ(96.f, output[998][100]);
+}
+
+TEST(convolve, border_policies_map_outside_indices)
+{
+    ASSERT_EQ(0, lib::border::replicate::map(-3, 4));
+    ASSERT_EQ(3, lib::border::replicate::map(5, 4));
+    ASSERT_EQ(1, lib::border::reflect::map(-1, 4));
+    ASSERT_EQ(2, lib::border::reflect::map(4, 4));
+    ASSERT_EQ(2, lib::border::reflect::map(-8, 4));
+    ASSERT_EQ(3, lib::border::wrap::map(-1, 4));
+    ASSERT_EQ(1, lib::border::wrap::map(9, 4));
+}
+
+TEST(convolve, full_size_convolution_matches_padded_input)
+{
+    lib::array2d<int> array(19, 23);
+    std::iota(array.begin(), array.end(), -200);
+
+    test_helper::expect_full_size_convolution(array, lib::border::constant{ 7 });
+    test_helper::expect_full_size_convolution(array, lib::border::replicate{});
+    test_helper::expect_full_size_convolution(array, lib::border::reflect{});
+    test_helper::expect_full_size_convolution(array, lib::border::wrap{});
+}
+
+TEST(convolve, full_size_convolution_handles_images_smaller_than_the_kernel)
+{
+    lib::array2d<int> array(3, 4);
+    std::iota(array.begin(), array.end(), 1);
+
+    test_helper::expect_full_size_convolution(array, lib::border::constant{});
+    test_helper::expect_full_size_convolution(array, lib::border::reflect{});
+    test_helper::expect_full_size_convolution(array, lib::border::wrap{});
+}
+
+TEST(convolve, even_kernels_are_anchored_at_the_top_left_of_their_center)
+{
+    lib::array2d<int> array(17, 21);
+    std::iota(array.begin(), array.end(), -150);
+
+    // Valid region: the window of output pixel (r, c) starts at input pixel (r, c)
+    auto valid = lib::convolve(array, lib::kernels::roberts_h<int>);
+    ASSERT_EQ(16, valid.rows());
+    ASSERT_EQ(20, valid.cols());
+    ASSERT_EQ(array[3][4] - array[4][5], valid[3][4]);
+
+    // Full size: the anchor (1, 1) of a 4x4 kernel lies on the output pixel, the 2x2 kernel is anchored at (0, 0)
+    const auto expect_anchored = [&](const auto& kernel, int anchor, const auto& result)
+    {
+        auto padded = test_helper::pad(array, 2, 2, lib::border::reflect{});
+        auto expected = test_helper::naive_convolve(padded, kernel);
+        for (int r = 0; r < array.rows(); r++)
+            for (int c = 0; c < array.cols(); c++)
+                ASSERT_EQ(expected[r + 2 - anchor][c + 2 - anchor], result.data()[r * array.cols() + c]) << r << " " << c;
+    };
+    auto factors = lib::make_separable_kernel<4, 4, int>({ 1, 3, 3, 1 }, { 2, -1, 0, 1 });
+    expect_anchored(lib::kernels::roberts_v<int>, 0, lib::convolve<lib::border::reflect>(array, lib::kernels::roberts_v<int>));
+    expect_anchored(lib::make_kernel(factors), 1, lib::convolve<lib::border::reflect>(lib::execution::par.with_grain(3), array, factors));
+    expect_anchored(lib::make_kernel(factors), 1, lib::convolve<lib::border::reflect>(array, lib::make_kernel(factors)));
+}
+
+TEST(convolve, full_size_convolution_supports_execution_policies)
+{
+    lib::array2d<int> array(101, 77);
+    std::iota(array.begin(), array.end(), -3000);
+
+    lib::thread_pool pool(3);
+    auto expected = lib::convolve<lib::border::reflect>(array, lib::kernels::sharpen<int>);
+
+    ASSERT_TRUE(expected == lib::convolve<lib::border::reflect>(lib::execution::par.on(pool).with_grain(4), array, lib::kernels::sharpen<int>));
+    ASSERT_TRUE(expected == lib::convolve<lib::border::reflect>(lib::execution::tiled.with_tile(9, 13), array, lib::kernels::sharpen<int>));
+}
+
+TEST(convolve, dynamic_kernel_matches_fixed_size_kernel)
+{
+    lib::array2d<int> array(41, 37);
+    std::iota(array.begin(), array.end(), -700);
+
+    auto factors = lib::make_separable_kernel<5, 7, int>({ 1, 4, 6, 4, 1 }, { -1, 2, 0, 3, 1, -2, 5 });
+    auto rectangular = lib::make_kernel(factors);
+    ASSERT_TRUE(test_helper::naive_convolve(array, rectangular) == lib::convolve(array, lib::make_dynamic_kernel(rectangular)));
+    ASSERT_TRUE(test_helper::naive_convolve(array, lib::kernels::sharpen<int>) == lib::convolve(array, lib::make_dynamic_kernel(lib::kernels::sharpen<int>)));
+
+    auto large = lib::kernel<13, 13, int>();
+    std::iota(large.values.begin(), large.values.end(), -80);
+    ASSERT_TRUE(test_helper::naive_convolve(array, large) == lib::convolve(lib::execution::tiled.with_tile(7, 9), array, lib::make_dynamic_kernel(large)));
+}
+
+TEST(convolve, gaussian_kernel_is_normalized_and_symmetric)
+{
+    auto gaussian = lib::make_gaussian_kernel<float>(7, 1.5);
+    ASSERT_EQ(7, gaussian.height);
+    ASSERT_EQ(7, gaussian.width);
+    ASSERT_NEAR(1.f, std::accumulate(gaussian.values.begin(), gaussian.values.end(), 0.f), 1e-5f);
+    for (int i = 0; i < 49; i++)
+        ASSERT_FLOAT_EQ(gaussian.values[i], gaussian.values[48 - i]);
+
+    auto integral = lib::make_gaussian_kernel<int>(3, 0.85);
+    ASSERT_THAT(integral.values, ::testing::ElementsAre(1, 2, 1, 2, 4, 2, 1, 2, 1));
+
+    lib::array2d<float> array(30, 30);
+    std::iota(array.begin(), array.end(), 0.f);
+    auto blurred = lib::convolve(array, gaussian);
+    ASSERT_EQ(24, blurred.rows());
+    ASSERT_NEAR(array[15][15], blurred[12][12], 1e-2f);
+}
+
+TEST(convolve, fft_convolution_matches_direct_convolution)
+{
+    lib::array2d<double> array(150, 133);
+    for (int j = 0; j < array.rows(); j++)
+        for (int i = 0; i < array.cols(); i++)
+            array[j][i] = std::sin(0.05 * j * i) + 0.01 * j;
+
+    auto kernel = lib::kernel<17, 21, double>();
+    for (std::size_t i = 0; i < kernel.values.size(); i++)
+        kernel.values[i] = std::cos(0.37 * i);
+
+    auto expected = test_helper::naive_convolve(array, kernel);
+    auto expect_near = [&](lib::array2d<double> result)
+    {
+        ASSERT_EQ(expected.rows(), result.rows());
+        ASSERT_EQ(expected.cols(), result.cols());
+        for (int j = 0; j < expected.rows(); j++)
+            for (int i = 0; i < expected.cols(); i++)
+                ASSERT_NEAR(expected[j][i], result[j][i], 1e-9);
+    };
+
+    lib::thread_pool pool(3);
+    expect_near(lib::fft_convolve(array, kernel));
+    expect_near(lib::fft_convolve(lib::execution::par.on(pool), array, lib::make_dynamic_kernel(kernel)));
+}
+
+TEST(convolve, crossover_picks_fft_only_for_large_kernels)
+{
+    ASSERT_FALSE(lib::internal::prefer_fft<float>(4320, 7680, 3, 3));
+    ASSERT_FALSE(lib::internal::prefer_fft<int>(4320, 7680, 63, 63));
+    ASSERT_FALSE(lib::internal::prefer_fft<float>(20, 20, 31, 31));
+    ASSERT_TRUE(lib::internal::prefer_fft<float>(4320, 7680, 63, 63));
+}
+
+namespace test_helper
+{
+    constexpr auto large_gaussian = lib::make_kernel<5, 5, int>(
+        1, 4, 6, 4, 1,
+        4, 16, 24, 16, 4,
+        6, 24, 36, 24, 6,
+        4, 16, 24, 16, 4,
+        1, 4, 6, 4, 1);
+
+    // Fixed point result computed through the int convolution
+    template<typename TOut, int Shift, std::size_t Height, std::size_t Width>
+    lib::array2d<TOut> fixed_point_reference(const lib::array2d<uint8_t>& image, const lib::kernel<Height, Width, int>& kernel)
+    {
+        lib::array2d<int> widened(image.rows(), image.cols());
+        for (std::size_t i = 0; i < image.size(); i++)
+            widened.data()[i] = image.data()[i];
+        auto sums = lib::convolve(widened, kernel);
+
+        lib::array2d<TOut> result(sums.rows(), sums.cols());
+        for (std::size_t i = 0; i < sums.size(); i++)
+        {
+            const auto shifted = (sums.data()[i] + (Shift > 0 ? 1 << (Shift - 1) : 0)) >> Shift;
+            result.data()[i] = static_cast<TOut>(std::clamp<int>(shifted, std::numeric_limits<TOut>::lowest(), std::numeric_limits<TOut>::max()));
+        }
+        return result;
+    }
+}
+
+TEST(convolve, fixed_point_accumulator_follows_kernel_bounds)
+{
+    static_assert(std::is_same_v<std::int16_t, lib::internal::fixed_point_accumulator<lib::kernels::gaussian_blur<int>, 4>>);
+    static_assert(std::is_same_v<std::int16_t, lib::internal::fixed_point_accumulator<lib::kernels::sobel_h<int>, 0>>);
+    static_assert(std::is_same_v<std::int32_t, lib::internal::fixed_point_accumulator<test_helper::large_gaussian, 8>>);
+}
+
+TEST(convolve, fixed_point_convolution_matches_int_convolution)
+{
+    lib::array2d<uint8_t> image(37, 53);
+    for (int j = 0; j < image.rows(); j++)
+        for (int i = 0; i < image.cols(); i++)
+            image[j][i] = static_cast<uint8_t>((j * 31 + i * i * 7) % 256);
+
+    ASSERT_TRUE((test_helper::fixed_point_reference<uint8_t, 4>(image, lib::kernels::gaussian_blur<int>) == lib::convolve_fixed<lib::kernels::gaussian_blur<int>, 4>(image)));
+    ASSERT_TRUE((test_helper::fixed_point_reference<uint8_t, 8>(image, test_helper::large_gaussian) == lib::convolve_fixed<test_helper::large_gaussian, 8>(image)));
+    ASSERT_TRUE((test_helper::fixed_point_reference<int16_t, 0>(image, lib::kernels::sobel_v<int>) == lib::convolve_fixed<lib::kernels::sobel_v<int>, 0, int16_t>(image)));
+    ASSERT_TRUE((test_helper::fixed_point_reference<uint8_t, 0>(image, lib::kernels::sharpen<int>) == lib::convolve_fixed<lib::kernels::sharpen<int>>(lib::execution::par, image)));
+}
+
+namespace test_helper
+{
+    // Copy of image whose rows are aligned and padded
+    template<typename T>
+    lib::array2d<T> aligned_copy(const lib::array2d<T>& image)
+    {
+        lib::array2d<T> result(image.rows(), image.cols(), lib::aligned_rows);
+        std::copy(image.begin(), image.end(), result.begin());
+        return result;
+    }
+}
+
+TEST(convolve, aligned_rows_give_the_same_result_as_dense_rows)
+{
+    lib::array2d<float> dense(41, 70);
+    for (int j = 0; j < dense.rows(); j++)
+        for (int i = 0; i < dense.cols(); i++)
+            dense[j][i] = std::sin(0.1f * j * i) + 0.02f * i;
+    const auto aligned = test_helper::aligned_copy(dense);
+    ASSERT_NE(aligned.cols(), aligned.stride());
+
+    const auto expect_into = [](const lib::array2d<float>& expected, auto&& convolve_into)
+    {
+        lib::array2d<float> output(expected.rows(), expected.cols(), lib::aligned_rows);
+        convolve_into(output);
+        ASSERT_TRUE(expected == output);
+    };
+
+    const auto box = lib::make_dynamic_kernel<float>(4, 4, std::vector<float>(16, 1.f / 16));
+    expect_into(lib::convolve(dense, lib::kernels::sharpen<float>), [&](auto& output) { lib::convolve_into(aligned, lib::kernels::sharpen<float>, output); });
+    expect_into(lib::convolve(dense, lib::kernels::gaussian_blur<float>), [&](auto& output) { lib::convolve_into(aligned, lib::kernels::gaussian_blur<float>, output); });
+    expect_into(lib::convolve(dense, box), [&](auto& output) { lib::convolve_into(lib::execution::tiled.with_tile(8, 16), aligned, box, output); });
+    expect_into(lib::convolve<lib::border::reflect>(dense, lib::kernels::gaussian_blur<float>),
+        [&](auto& output) { lib::convolve_into<lib::border::reflect>(aligned, lib::kernels::gaussian_blur<float>, output); });
+}
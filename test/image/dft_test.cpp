@@ -18,3 +18,58 @@ TEST(dft_test, one_dimensional_dft_returns_correct_result)
     EXPECT_THAT(result, ::testing::ElementsAreArray({ 4, 0, 0, 0 }));
 }
 
+
+TEST(dft_test, naive_dft_transforms_input_values)
+{
+    std::vector<std::complex<double>> test_data{ 1., 2., 3., 4. };
+    auto dft_result = lib::naive_dft(test_data);
+
+    EXPECT_NEAR(10., dft_result[0].real(), 1e-12);
+    EXPECT_NEAR(-2., dft_result[1].real(), 1e-12);
+    EXPECT_NEAR(2., dft_result[1].imag(), 1e-12);
+    EXPECT_NEAR(-2., dft_result[2].real(), 1e-12);
+}
+
+TEST(dft_test, fft_matches_naive_dft_and_inverts)
+{
+    std::vector<std::complex<double>> test_data(64);
+    for (std::size_t i = 0; i < test_data.size(); i++)
+        test_data[i] = std::complex<double>(std::sin(0.3 * i) + 0.1 * i, std::cos(1.7 * i));
+
+    auto expected = lib::naive_dft(test_data);
+    auto result = test_data;
+    lib::fft_plan<double> plan(result.size());
+    plan.forward(result.data());
+    for (std::size_t i = 0; i < result.size(); i++)
+        EXPECT_NEAR(0., std::abs(expected[i] - result[i]), 1e-9);
+
+    plan.inverse(result.data());
+    for (std::size_t i = 0; i < result.size(); i++)
+        EXPECT_NEAR(0., std::abs(test_data[i] - result[i]), 1e-12);
+}
+
+TEST(dft_test, real_fft_matches_naive_dft_and_inverts)
+{
+    for (std::size_t n : { 2, 4, 8, 32 })
+    {
+        std::vector<double> test_data(n);
+        std::vector<std::complex<double>> complex_data(n);
+        for (std::size_t i = 0; i < n; i++)
+        {
+            test_data[i] = std::sin(0.7 * i) + 0.25 * i;
+            complex_data[i] = test_data[i];
+        }
+
+        auto expected = lib::naive_dft(complex_data);
+        lib::real_fft_plan<double> plan(n);
+        std::vector<std::complex<double>> spectrum(plan.bins());
+        plan.forward(test_data.data(), spectrum.data());
+        for (std::size_t i = 0; i < plan.bins(); i++)
+            EXPECT_NEAR(0., std::abs(expected[i] - spectrum[i]), 1e-9) << "n = " << n << ", bin " << i;
+
+        std::vector<double> result(n);
+        plan.inverse(spectrum.data(), result.data());
+        for (std::size_t i = 0; i < n; i++)
+            EXPECT_NEAR(test_data[i], result[i], 1e-12) << "n = " << n << ", sample " << i;
+    }
+}
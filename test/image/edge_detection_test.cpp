@@ -2,6 +2,11 @@
 #include <gmock/gmock.h>
 #include <image/image.h>
 #include <core/core.h>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
 
 TEST(edge_detection, sobel)
 {
@@ -14,3 +19,496 @@ TEST(edge_detection, sobel)
     auto output = lib::convert<uint8_t>(result);
     lib::write_image("./TestResults/edge_detection_sobel.jpg", output);
 }
+
+TEST(edge_detection, parallel_sobel_matches_sequential)
+{
+    lib::array2d<lib::rgb_pixel_u8> image_data;
+    lib::read_image("./TestData/lena.jpg", image_data);
+    auto tmp = lib::convert<uint8_t, lib::grayscale_mode::Luminosity>(image_data);
+
+    lib::thread_pool pool(4);
+    auto expected = lib::sobel(tmp);
+    auto result = lib::sobel(lib::execution::par.on(pool).with_grain(3), tmp);
+
+    ASSERT_TRUE(expected == result);
+}
+
+TEST(edge_detection, sobel_into_matches_allocating_sobel)
+{
+    lib::array2d<lib::rgb_pixel_u8> image_data;
+    lib::read_image("./TestData/lena.jpg", image_data);
+    auto gray = lib::array2d<uint8_t>(image_data.rows(), image_data.cols());
+    lib::convert_into<lib::grayscale_mode::Luminosity>(image_data, gray);
+
+    auto gradient = lib::array2d<uint8_t>(gray.rows() - 2, gray.cols() - 2);
+    lib::sobel_into(gray, gradient);
+    ASSERT_TRUE(lib::sobel(gray) == gradient);
+
+    auto full_size = lib::array2d<uint8_t>(gray.rows(), gray.cols());
+    lib::sobel_into<lib::border::replicate>(gray, full_size);
+    ASSERT_TRUE(lib::sobel<lib::border::replicate>(gray) == full_size);
+}
+
+TEST(edge_detection, into_rejects_outputs_of_the_wrong_shape)
+{
+    auto input = lib::array2d<float>(10, 12);
+    auto too_small = lib::array2d<float>(7, 10);
+    auto full_size = lib::array2d<float>(10, 12);
+    ASSERT_THROW(lib::sobel_into(input, too_small), std::invalid_argument);
+    ASSERT_THROW(lib::sobel_into(input, full_size), std::invalid_argument);
+    ASSERT_THROW(lib::convolve_into(input, lib::kernels::gaussian_blur<float>, too_small), std::invalid_argument);
+}
+
+TEST(edge_detection, grayscale_sobel_matches_convert_then_sobel)
+{
+    lib::array2d<lib::rgb_pixel_u8> image_data;
+    lib::read_image("./TestData/lena.jpg", image_data);
+
+    auto expected = lib::sobel(lib::convert<float, lib::grayscale_mode::Luminosity>(image_data));
+    ASSERT_TRUE(expected == lib::grayscale_sobel<float>(image_data));
+    ASSERT_TRUE(expected == lib::grayscale_sobel<float>(lib::execution::par.with_grain(7), image_data));
+
+    auto expected_u8 = lib::sobel(lib::convert<uint8_t, lib::grayscale_mode::Average>(image_data));
+    ASSERT_TRUE(expected_u8 == (lib::grayscale_sobel<uint8_t, lib::grayscale_mode::Average>(image_data)));
+}
+
+TEST(edge_detection, magnitude_modes_combine_gradients)
+{
+    // A vertical step of 10 gives gx = 40 and gy = 0 in the middle, a diagonal one gx = gy = 30
+    lib::array2d<int> step(3, 4);
+    lib::array2d<int> diagonal(3, 3);
+    const int step_values[] = { 0, 0, 10, 10, 0, 0, 10, 10, 0, 0, 10, 10 };
+    const int diagonal_values[] = { 0, 0, 0, 0, 0, 10, 0, 10, 10 };
+    std::copy(std::begin(step_values), std::end(step_values), step.begin());
+    std::copy(std::begin(diagonal_values), std::end(diagonal_values), diagonal.begin());
+
+    ASSERT_EQ(40, lib::sobel(step, lib::magnitude_mode::L1).data()[0]);
+    ASSERT_EQ(1600, lib::sobel(step, lib::magnitude_mode::Squared).data()[0]);
+    ASSERT_EQ(38, lib::sobel(step, lib::magnitude_mode::Approximate).data()[0]);
+
+    ASSERT_EQ(42, lib::sobel(diagonal).data()[0]);
+    ASSERT_EQ(60, lib::sobel(diagonal, lib::magnitude_mode::L1).data()[0]);
+    ASSERT_EQ(1800, lib::sobel(diagonal, lib::magnitude_mode::Squared).data()[0]);
+    ASSERT_EQ(40, lib::sobel(diagonal, lib::magnitude_mode::Approximate).data()[0]);
+    ASSERT_EQ(40, lib::sobel<lib::border::replicate>(diagonal, lib::border::replicate{}, lib::magnitude_mode::Approximate).data()[4]);
+}
+
+TEST(edge_detection, squared_magnitude_is_exact_on_wide_integral_outputs)
+{
+    // A step of 60000 gives gx = 240000, whose square saturates int, a step of 5000 gives 20000^2 = 4e8, beyond the
+    // 2^24 that float represents exactly
+    lib::array2d<int> step(3, 4);
+    const int step_values[] = { 0, 0, 5000, 60000, 0, 0, 5000, 60000, 0, 0, 5000, 60000 };
+    std::copy(std::begin(step_values), std::end(step_values), step.begin());
+    auto squared = lib::sobel(step, lib::magnitude_mode::Squared);
+    ASSERT_EQ(400000000, squared.data()[0]);
+    ASSERT_EQ(std::numeric_limits<int>::max(), squared.data()[1]);
+    ASSERT_EQ(std::numeric_limits<int>::max(), lib::roberts(step, lib::magnitude_mode::Squared).data()[2]);
+
+    lib::array2d<std::uint8_t> bytes(3, 4);
+    ASSERT_THROW((void)lib::sobel(bytes, lib::magnitude_mode::Squared), std::invalid_argument);
+}
+
+TEST(edge_detection, full_size_sobel_keeps_interior_and_reads_border)
+{
+    lib::array2d<lib::rgb_pixel_u8> image_data;
+    lib::read_image("./TestData/lena.jpg", image_data);
+    auto tmp = lib::convert<uint8_t, lib::grayscale_mode::Luminosity>(image_data);
+
+    auto shrunk = lib::sobel(tmp);
+    auto result = lib::sobel<lib::border::replicate>(tmp);
+    ASSERT_EQ(tmp.rows(), result.rows());
+    ASSERT_EQ(tmp.cols(), result.cols());
+
+    for (int j = 0; j < shrunk.rows(); j++)
+        for (int i = 0; i < shrunk.cols(); i++)
+            ASSERT_EQ(shrunk[j][i], result[j + 1][i + 1]);
+
+    // A replicated border has no gradient across the image edge
+    lib::array2d<uint8_t> flat(4, 5);
+    std::fill(flat.begin(), flat.end(), uint8_t{ 90 });
+    for (const auto& value : lib::sobel<lib::border::replicate>(flat))
+        ASSERT_EQ(0, value);
+
+    // Against a zero border the edge pixels see a step of 90: gx = 4 * 90 on the left column, gy = 0 in the middle rows
+    auto zero_border = lib::sobel(flat, lib::border::constant{});
+    ASSERT_EQ(255, zero_border[1][0]);
+    ASSERT_EQ(0, zero_border[1][2]);
+}
+
+TEST(edge_detection, roberts_combines_both_diagonal_differences)
+{
+    lib::array2d<lib::rgb_pixel_u8> image_data;
+    lib::read_image("./TestData/lena.jpg", image_data);
+    auto gray = lib::convert<float, lib::grayscale_mode::Luminosity>(image_data);
+
+    auto gx = lib::convolve(gray, lib::kernels::roberts_h<float>);
+    auto gy = lib::convolve(gray, lib::kernels::roberts_v<float>);
+    auto result = lib::roberts(lib::execution::par.with_grain(11), gray, lib::magnitude_mode::L1);
+    ASSERT_EQ(gray.rows() - 1, result.rows());
+    ASSERT_EQ(gray.cols() - 1, result.cols());
+    for (std::size_t i = 0; i < result.size(); i++)
+        ASSERT_FLOAT_EQ(std::min(1.f, std::abs(gx.data()[i]) + std::abs(gy.data()[i])), result.data()[i]);
+
+    auto output = lib::convert<uint8_t>(lib::roberts(gray));
+    lib::write_image("./TestResults/edge_detection_roberts.jpg", output);
+}
+
+TEST(edge_detection, canny_traces_a_thin_closed_contour)
+{
+    lib::array2d<uint8_t> square(40, 40);
+    std::fill(square.begin(), square.end(), uint8_t{ 20 });
+    for (int row = 10; row < 30; row++)
+        std::fill(square.data() + row * 40 + 10, square.data() + row * 40 + 30, uint8_t{ 200 });
+
+    auto edges = lib::canny(square, 100, 300);
+    for (int row = 0; row < 40; row++)
+    {
+        auto count = 0;
+        for (int col = 0; col < 40; col++)
+        {
+            const auto value = edges.data()[row * 40 + col];
+            ASSERT_TRUE(value == 0 || value == 255);
+            count += value == 255;
+
+            // Only pixels next to the step can be edges
+            const auto near_row = row >= 8 && row <= 31;
+            const auto near_col = col >= 8 && col <= 31;
+            const auto inside = row >= 12 && row <= 27 && col >= 12 && col <= 27;
+            if (value == 255)
+            {
+                ASSERT_TRUE(near_row && near_col && !inside);
+            }
+        }
+
+        // Non maximum suppression leaves one pixel per crossing of the left and the right step
+        if (row >= 13 && row <= 26)
+        {
+            ASSERT_EQ(2, count);
+        }
+    }
+
+    auto no_edges = lib::canny(square, 2000, 3000);
+    for (const auto& value : no_edges)
+        ASSERT_EQ(0, value);
+}
+
+TEST(edge_detection, canny_reuses_workspace_and_supports_policies)
+{
+    lib::array2d<lib::rgb_pixel_u8> image_data;
+    lib::read_image("./TestData/lena.jpg", image_data);
+    auto gray = lib::convert<uint8_t, lib::grayscale_mode::Luminosity>(image_data);
+
+    auto expected = lib::canny(gray, 40, 100);
+    lib::write_image("./TestResults/canny.jpg", expected);
+
+    lib::canny_workspace workspace;
+    auto edges = lib::array2d<uint8_t>(gray.rows(), gray.cols());
+    for (int repeat = 0; repeat < 2; repeat++)
+    {
+        lib::canny_into(lib::execution::par.with_grain(5), gray, edges, workspace, 40, 100);
+        ASSERT_TRUE(expected == edges);
+    }
+}
+
+TEST(edge_detection, canny_hysteresis_joins_components_across_bands)
+{
+    // A weak zigzag through every row whose only strong pixel is at the bottom, and a weak line that touches nothing
+    constexpr auto none = lib::internal::canny_none;
+    constexpr auto weak = lib::internal::canny_weak;
+    constexpr auto edge = lib::internal::canny_edge;
+    lib::array2d<uint8_t> states(24, 16);
+    std::fill(states.begin(), states.end(), none);
+    for (int row = 0; row < 24; row++)
+    {
+        states.data()[row * 16 + (row % 4 < 2 ? row % 4 : 4 - row % 4)] = weak;
+        states.data()[row * 16 + 12] = row < 20 ? weak : none;
+    }
+    states.data()[23 * 16 + 1] = edge;
+
+    const auto check = [&](const auto& policy)
+    {
+        lib::array2d<uint8_t> edges(24, 16);
+        std::copy(states.data(), states.data() + states.size(), edges.data());
+        lib::canny_workspace workspace;
+        lib::internal::canny_hysteresis(policy, edges, workspace);
+        for (int row = 0; row < 24; row++)
+        {
+            for (int col = 0; col < 16; col++)
+            {
+                const auto expected = states.data()[row * 16 + col] != none && col < 12 ? edge : none;
+                ASSERT_EQ(expected, edges.data()[row * 16 + col]);
+            }
+        }
+    };
+    check(lib::execution::seq);
+    check(lib::execution::par.with_grain(1));
+    check(lib::execution::par.with_grain(3));
+    check(lib::execution::tiled.with_tile(5, 16));
+}
+
+TEST(edge_detection, gradient_sector_matches_atan2_quantization)
+{
+    std::mt19937 generator(3);
+    std::uniform_real_distribution<float> distribution(-500.f, 500.f);
+    for (int i = 0; i < 10000; i++)
+    {
+        const auto gx = distribution(generator);
+        const auto gy = distribution(generator);
+        auto angle = std::atan2(gy, gx) * 180.0 / M_PI;
+        if (angle < 0)
+            angle += 180;
+
+        // Skip gradients right on a sector boundary, where rounding may go either way
+        if (std::abs(std::fmod(angle - 22.5, 45.0)) < 1e-3)
+            continue;
+        const auto expected = angle < 22.5 || angle >= 157.5 ? 0 : angle < 67.5 ? 1 : angle < 112.5 ? 2 : 3;
+        ASSERT_EQ(expected, lib::internal::gradient_sector(gx, gy)) << gx << " " << gy;
+    }
+}
+
+TEST(edge_detection, non_maximum_suppression_thins_the_sobel_magnitude)
+{
+    lib::array2d<uint8_t> ramp(20, 20);
+    for (int row = 0; row < 20; row++)
+    {
+        for (int col = 0; col < 20; col++)
+            ramp.data()[row * 20 + col] = static_cast<uint8_t>(col < 9 ? 10 : col < 11 ? 60 : 110);
+    }
+
+    auto thin = lib::non_maximum_suppression(ramp);
+    auto par_thin = lib::non_maximum_suppression(lib::execution::par.with_grain(2), ramp);
+    ASSERT_EQ(18, thin.rows());
+    ASSERT_EQ(18, thin.cols());
+    ASSERT_TRUE(thin == par_thin);
+    for (int row = 0; row < 18; row++)
+    {
+        // The two steps give four sobel columns with equal responses, the plateau keeps only its last pixel
+        for (int col = 0; col < 18; col++)
+            ASSERT_EQ(col == 10 ? 200.f : 0.f, thin.data()[row * 18 + col]) << row << " " << col;
+    }
+
+    ASSERT_EQ(0u, lib::non_maximum_suppression(lib::array2d<uint8_t>(2, 20)).size());
+    ASSERT_EQ(0u, lib::non_maximum_suppression(lib::array2d<uint8_t>(1, 1)).size());
+}
+
+TEST(edge_detection, compass_kernels_rotate_the_outer_ring)
+{
+    constexpr auto kirsch = lib::kernels::kirsch_compass<int>;
+    constexpr std::array<int, 9> east = { -3, -3, 5, -3, 0, 5, -3, -3, 5 };
+    static_assert(kirsch[1].values[1] == 5 && kirsch[1].values[3] == -3, "Generated at compile time");
+    ASSERT_EQ(lib::kernels::kirsch<int>.values, kirsch[0].values);
+    ASSERT_EQ(east, kirsch[2].values);
+    ASSERT_EQ(kirsch[0].values, lib::rotate_45(kirsch[7]).values);
+
+    // Opposite directions of the prewitt bank are negated
+    for (int k = 0; k < 4; k++)
+    {
+        for (int i = 0; i < 9; i++)
+            ASSERT_EQ(-lib::kernels::prewitt_compass<int>[k].values[i], lib::kernels::prewitt_compass<int>[k + 4].values[i]);
+    }
+}
+
+TEST(edge_detection, compass_edges_keeps_the_strongest_of_eight_convolutions)
+{
+    lib::array2d<lib::rgb_pixel_u8> image_data;
+    lib::read_image("./TestData/lena.jpg", image_data);
+    auto gray = lib::convert<float, lib::grayscale_mode::Luminosity>(image_data);
+
+    const auto& bank = lib::kernels::kirsch_compass<float>;
+    std::vector<lib::array2d<float>> responses;
+    for (const auto& kernel : bank)
+        responses.push_back(lib::convolve(gray, kernel));
+
+    auto edges = lib::array2d<float>(gray.rows() - 2, gray.cols() - 2);
+    auto directions = lib::array2d<uint8_t>(gray.rows() - 2, gray.cols() - 2);
+    lib::compass_edges_into(lib::execution::par.with_grain(7), gray, bank, edges, directions);
+    for (std::size_t i = 0; i < edges.size(); i++)
+    {
+        auto best = 0;
+        for (int k = 1; k < 8; k++)
+            best = responses[k].data()[i] > responses[best].data()[i] ? k : best;
+        ASSERT_NEAR(std::clamp(responses[best].data()[i], 0.f, 1.f), edges.data()[i], 1e-5f);
+        ASSERT_NEAR(responses[best].data()[i], responses[directions.data()[i]].data()[i], 1e-5f);
+    }
+    auto output = lib::convert<uint8_t>(edges);
+    lib::write_image("./TestResults/compass_edges.jpg", output);
+
+    auto bytes = lib::convert<uint8_t, lib::grayscale_mode::Luminosity>(image_data);
+    auto byte_edges = lib::compass_edges(bytes, lib::kernels::prewitt_compass<int>);
+    auto prewitt_x = lib::convolve(lib::convert<int>(bytes), lib::kernels::prewitt_h<int>);
+    for (std::size_t i = 0; i < byte_edges.size(); i++)
+        ASSERT_GE(byte_edges.data()[i], static_cast<uint8_t>(std::clamp(prewitt_x.data()[i], 0, 255)));
+}
+
+TEST(edge_detection, laplacian_of_gaussian_matches_the_dense_kernel)
+{
+    lib::array2d<lib::rgb_pixel_u8> image_data;
+    lib::read_image("./TestData/lena.jpg", image_data);
+    auto gray = lib::convert<float, lib::grayscale_mode::Luminosity>(image_data);
+
+    // The dense 9x9 kernel as the sum of the outer products of both factor pairs
+    constexpr auto size = 9;
+    const auto factors = lib::internal::make_laplacian_factors<float>(size, 1.4, lib::laplacian_mode::Separable);
+    auto dense = lib::dynamic_kernel<float>{ size, size, std::vector<float>(size * size) };
+    for (int r = 0; r < size; r++)
+    {
+        for (int c = 0; c < size; c++)
+            dense.values[r * size + c] = factors.first_column[r] * factors.first_row[c] + factors.second_column[r] * factors.second_row[c];
+    }
+    auto expected = lib::convolve(gray, dense);
+
+    auto separable = lib::laplacian_of_gaussian(lib::execution::par.with_grain(9), gray, size, 1.4);
+    auto dog = lib::laplacian_of_gaussian(gray, size, 1.4, lib::laplacian_mode::DifferenceOfGaussians);
+    ASSERT_TRUE(separable == lib::laplacian_of_gaussian(gray, size, 1.4));
+    ASSERT_EQ(expected.rows(), separable.rows());
+    ASSERT_EQ(expected.cols(), separable.cols());
+    auto error = 0.0;
+    auto energy = 0.0;
+    for (std::size_t i = 0; i < expected.size(); i++)
+    {
+        ASSERT_NEAR(expected.data()[i], separable.data()[i], 1e-5f);
+        error += std::pow(dog.data()[i] - separable.data()[i], 2);
+        energy += std::pow(separable.data()[i], 2);
+    }
+
+    // The difference of gaussians only approximates the laplacian
+    ASSERT_LT(error, 0.1 * energy);
+}
+
+TEST(edge_detection, laplacian_of_gaussian_of_an_image_smaller_than_the_kernel_is_empty)
+{
+    auto small = lib::array2d<float>(5, 12);
+    auto empty = lib::array2d<float>(0, 4);
+    lib::laplacian_of_gaussian_into(small, empty, 9, 1.4);
+    ASSERT_EQ(0u, lib::laplacian_of_gaussian(small, 9, 1.4).size());
+}
+
+TEST(edge_detection, zero_crossings_of_a_step_mark_the_step)
+{
+    lib::array2d<float> step(30, 30);
+    for (int row = 0; row < 30; row++)
+    {
+        for (int col = 0; col < 30; col++)
+            step.data()[row * 30 + col] = col < 15 ? 0.2f : 0.8f;
+    }
+
+    // The response is 6 pixels smaller, the step lies between its columns 11 and 12 and one of the two is marked
+    auto response = lib::laplacian_of_gaussian(step, 7, 1.0);
+    lib::array2d<float> constant(10, 10);
+    std::fill(constant.begin(), constant.end(), 0.5f);
+    auto flat = lib::laplacian_of_gaussian(constant, 7, 1.0);
+    for (const auto& value : flat)
+        ASSERT_NEAR(0.f, value, 1e-6f);
+
+    auto edges = lib::zero_crossings(lib::execution::par.with_grain(2), response, 0.05);
+    for (int row = 0; row < 24; row++)
+    {
+        auto count = 0;
+        for (int col = 0; col < 24; col++)
+        {
+            const auto value = edges.data()[row * 24 + col];
+            ASSERT_TRUE(value == 0 || (value == 255 && (col == 11 || col == 12))) << row << " " << col;
+            count += value == 255;
+        }
+        ASSERT_EQ(row > 0 && row < 23 ? 1 : 0, count);
+    }
+
+    auto no_edges = lib::zero_crossings(response, 10.0);
+    for (const auto& value : no_edges)
+        ASSERT_EQ(0, value);
+}
+
+TEST(edge_detection, sobel_gradients_match_sobel_and_quantize_the_direction)
+{
+    lib::array2d<lib::rgb_pixel_u8> image_data;
+    lib::read_image("./TestData/lena.jpg", image_data);
+    auto gray = lib::convert<uint8_t, lib::grayscale_mode::Luminosity>(image_data);
+
+    auto gradients = lib::sobel_gradients(lib::execution::par.with_grain(13), gray, 9);
+    ASSERT_TRUE(lib::sobel(gray) == gradients.magnitude);
+    for (const auto& bin : gradients.orientation)
+        ASSERT_LT(bin, 9);
+
+    auto planes = lib::sobel_planes<int16_t>(gray);
+    auto wide = lib::convert<int>(gray);
+    auto gx = lib::convolve(wide, lib::kernels::sobel_h<int>);
+    auto gy = lib::convolve(wide, lib::kernels::sobel_v<int>);
+    for (std::size_t i = 0; i < gx.size(); i++)
+    {
+        ASSERT_EQ(gx.data()[i], planes.x.data()[i]);
+        ASSERT_EQ(gy.data()[i], planes.y.data()[i]);
+    }
+
+    // Ramps along (c, r) have the gradient (-80c, -80r): 180, 270 and 225 degrees
+    const auto ramp_bins = [](int c, int r, int bins, lib::orientation_range range)
+    {
+        lib::array2d<uint8_t> ramp(5, 5);
+        for (int row = 0; row < 5; row++)
+            for (int col = 0; col < 5; col++)
+                ramp.data()[row * 5 + col] = static_cast<uint8_t>(10 * (c * col + r * row));
+        return lib::sobel_gradients(ramp, bins, range).orientation;
+    };
+    const std::tuple<int, int, int, int> expected[] = { { 1, 0, 0, 3 }, { 0, 1, 4, 5 }, { 1, 1, 2, 4 } };
+    for (const auto& [c, r, half_bin, full_bin] : expected)
+    {
+        for (const auto& bin : ramp_bins(c, r, 9, lib::orientation_range::Half))
+            ASSERT_EQ(half_bin, bin);
+        for (const auto& bin : ramp_bins(c, r, 7, lib::orientation_range::Full))
+            ASSERT_EQ(full_bin, bin);
+    }
+}
+
+TEST(edge_detection, aligned_rows_give_the_same_edges_as_dense_rows)
+{
+    lib::array2d<lib::rgb_pixel_u8> image_data;
+    lib::read_image("./TestData/lena.jpg", image_data);
+    auto gray = lib::convert<uint8_t, lib::grayscale_mode::Luminosity>(image_data);
+    auto aligned = lib::array2d<uint8_t>(gray.rows(), gray.cols(), lib::aligned_rows);
+    std::copy(gray.begin(), gray.end(), aligned.begin());
+
+    const auto aligned_output = [](int rows, int cols) { return lib::array2d<uint8_t>(rows, cols, lib::aligned_rows); };
+
+    auto gradient = aligned_output(gray.rows() - 2, gray.cols() - 2);
+    lib::sobel_into(aligned, gradient);
+    ASSERT_TRUE(lib::sobel(gray) == gradient);
+
+    auto full_size = aligned_output(gray.rows(), gray.cols());
+    lib::sobel_into<lib::border::replicate>(aligned, full_size);
+    ASSERT_TRUE(lib::sobel<lib::border::replicate>(gray) == full_size);
+
+    auto diagonal = aligned_output(gray.rows() - 1, gray.cols() - 1);
+    lib::roberts_into(aligned, diagonal);
+    ASSERT_TRUE(lib::roberts(gray) == diagonal);
+
+    auto edges = aligned_output(gray.rows(), gray.cols());
+    lib::canny_workspace workspace;
+    lib::canny_into(lib::execution::par.with_grain(7), aligned, edges, workspace, 40, 100);
+    ASSERT_TRUE(lib::canny(gray, 40, 100) == edges);
+}
+
+TEST(edge_detection, region_of_interest_matches_the_cropped_copy)
+{
+    lib::array2d<lib::rgb_pixel_u8> image_data;
+    lib::read_image("./TestData/lena.jpg", image_data);
+    const auto gray = lib::convert<uint8_t, lib::grayscale_mode::Luminosity>(image_data);
+
+    const auto roi = gray.subview(100, 150, 64, 96);
+    auto crop = lib::array2d<uint8_t>(roi.rows(), roi.cols());
+    std::copy(roi.begin(), roi.end(), crop.begin());
+
+    ASSERT_TRUE(lib::sobel(crop) == lib::sobel(roi));
+    ASSERT_TRUE(lib::convolve(lib::convert<float>(crop), lib::kernels::gaussian_blur<float>) == lib::convolve(lib::convert<float>(roi), lib::kernels::gaussian_blur<float>));
+
+    // Results can be written into a region of a larger image as well
+    auto frame = lib::array2d<uint8_t>(gray.rows(), gray.cols());
+    std::fill(frame.begin(), frame.end(), uint8_t{ 7 });
+    auto target = frame.subview(10, 20, roi.rows() - 2, roi.cols() - 2);
+    lib::sobel_into(roi, target);
+    ASSERT_TRUE(lib::sobel(crop) == target);
+    ASSERT_EQ(7, frame[9][20]);
+    ASSERT_EQ(7, frame[10][19]);
+    ASSERT_EQ(7, frame[10][20 + roi.cols() - 2]);
+
+    lib::write_image("./TestResults/region_of_interest.jpg", roi);
+}
@@ -44,3 +44,14 @@ TEST(image_converter, converts_color_to_grayscale_lightness)
     auto result = lib::convert<uint8_t, lib::grayscale_mode::Lightness>(image_data);
     lib::write_image("./TestResults/converts_color_to_grayscale_lightness.jpg", result);
 }
+
+TEST(image_converter, parallel_conversion_matches_sequential)
+{
+    lib::array2d<lib::rgb_pixel_u8> image_data;
+    lib::read_image("./TestData/lena.jpg", image_data);
+
+    auto expected = lib::convert<uint8_t, lib::grayscale_mode::Luminosity>(image_data);
+    auto result = lib::convert<uint8_t, lib::grayscale_mode::Luminosity>(lib::execution::par.with_grain(1), image_data);
+
+    ASSERT_TRUE(expected == result);
+}
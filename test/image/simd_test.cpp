@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <image/image.h>
+#include <core/core.h>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace test_helper
+{
+    // Restores runtime dispatch to the best supported level when a test ends
+    class simd_level_guard
+    {
+    public:
+        ~simd_level_guard()
+        {
+            lib::simd::set_level(lib::max_simd_level());
+        }
+    };
+
+    template<typename T>
+    lib::array2d<T> random_image(int rows, int cols, int min, int max)
+    {
+        std::mt19937 generator(42);
+        std::uniform_int_distribution<int> distribution(min, max);
+        lib::array2d<T> image(rows, cols);
+        for (auto& pixel : image)
+        {
+            if constexpr (std::is_floating_point_v<T>)
+                pixel = static_cast<T>(distribution(generator)) / static_cast<T>(max);
+            else
+                pixel = static_cast<T>(distribution(generator));
+        }
+        return image;
+    }
+
+    std::vector<lib::simd_level> supported_vector_levels()
+    {
+        std::vector<lib::simd_level> levels;
+        for (auto level : { lib::simd_level::SSE41, lib::simd_level::AVX2, lib::simd_level::AVX512 })
+        {
+            if (level <= lib::max_simd_level())
+                levels.push_back(level);
+        }
+        return levels;
+    }
+
+    template<typename T>
+    void expect_equal(const lib::array2d<T>& expected, const lib::array2d<T>& actual)
+    {
+        ASSERT_EQ(expected.rows(), actual.rows());
+        ASSERT_EQ(expected.cols(), actual.cols());
+        auto expected_it = expected.cbegin();
+        for (auto actual_it = actual.cbegin(); actual_it != actual.cend(); actual_it++, expected_it++)
+        {
+            if constexpr (std::is_floating_point_v<T>)
+                ASSERT_NEAR(*expected_it, *actual_it, 1e-5);
+            else
+                ASSERT_EQ(*expected_it, *actual_it);
+        }
+    }
+
+    template<typename T>
+    void expect_vectorized_convolution_matches_scalar(int min, int max)
+    {
+        simd_level_guard guard;
+        auto image = random_image<T>(23, 45, min, max);
+        auto separable = lib::kernels::gaussian_blur<T>;
+        auto dense = lib::make_kernel<3, 5, T>(
+            1, 0, 2, 1, 3,
+            0, 1, 1, 2, 0,
+            3, 0, 1, 0, 1);
+
+        lib::simd::set_level(lib::simd_level::Scalar);
+        ASSERT_EQ(lib::simd_level::Scalar, lib::simd::active_level());
+        auto expected_separable = lib::convolve(image, separable);
+        auto expected_dense = lib::convolve(image, dense);
+
+        for (auto level : supported_vector_levels())
+        {
+            ASSERT_EQ(level, lib::simd::set_level(level));
+            expect_equal(expected_separable, lib::convolve(image, separable));
+            expect_equal(expected_dense, lib::convolve(image, dense));
+        }
+    }
+
+    // Runs the gradient operator, apply(image, magnitude), on every supported level and every magnitude mode
+    template<typename T, typename Operator>
+    void expect_vectorized_operator_matches_scalar(Operator&& apply, const lib::array2d<T>& image)
+    {
+        simd_level_guard guard;
+        for (auto magnitude : { lib::magnitude_mode::L2, lib::magnitude_mode::L1, lib::magnitude_mode::Squared, lib::magnitude_mode::Approximate })
+        {
+            // Squared magnitudes do not fit 8-bit outputs
+            if (std::is_integral_v<T> && sizeof(T) < sizeof(int) && magnitude == lib::magnitude_mode::Squared)
+                continue;
+
+            lib::simd::set_level(lib::simd_level::Scalar);
+            auto expected = apply(image, magnitude);
+
+            for (auto level : supported_vector_levels())
+            {
+                lib::simd::set_level(level);
+                expect_equal(expected, apply(image, magnitude));
+            }
+        }
+    }
+
+    template<typename T, typename Operator>
+    void expect_vectorized_operator_matches_scalar(Operator&& apply, int min, int max)
+    {
+        expect_vectorized_operator_matches_scalar(apply, random_image<T>(19, 53, min, max));
+    }
+
+    constexpr auto sobel = [](const auto& image, lib::magnitude_mode magnitude) { return lib::sobel(image, magnitude); };
+    constexpr auto roberts = [](const auto& image, lib::magnitude_mode magnitude) { return lib::roberts(image, magnitude); };
+}
+
+TEST(simd, set_level_is_clamped_to_cpu_support)
+{
+    test_helper::simd_level_guard guard;
+    ASSERT_EQ(lib::max_simd_level(), lib::simd::set_level(lib::simd_level::AVX512));
+    ASSERT_EQ(lib::simd_level::Scalar, lib::simd::set_level(lib::simd_level::Scalar));
+    ASSERT_EQ(nullptr, lib::simd::active_kernels());
+}
+
+TEST(simd, convolve_float_matches_scalar)
+{
+    test_helper::expect_vectorized_convolution_matches_scalar<float>(0, 255);
+}
+
+TEST(simd, convolve_int_matches_scalar)
+{
+    test_helper::expect_vectorized_convolution_matches_scalar<int>(-1000, 1000);
+}
+
+TEST(simd, convolve_uint8_matches_scalar)
+{
+    test_helper::expect_vectorized_convolution_matches_scalar<std::uint8_t>(0, 255);
+}
+
+TEST(simd, sobel_float_matches_scalar)
+{
+    test_helper::expect_vectorized_operator_matches_scalar<float>(test_helper::sobel, 0, 255);
+}
+
+TEST(simd, sobel_int_matches_scalar)
+{
+    test_helper::expect_vectorized_operator_matches_scalar<int>(test_helper::sobel, 0, 65535);
+}
+
+TEST(simd, sobel_uint8_matches_scalar)
+{
+    test_helper::expect_vectorized_operator_matches_scalar<std::uint8_t>(test_helper::sobel, 0, 255);
+}
+
+TEST(simd, sobel_uint8_diagonal_edges_match_scalar)
+{
+    // Corners of the stripes give |gx| = |gy| = 765, the largest weighted sums of the approximation
+    lib::array2d<std::uint8_t> image(19, 53);
+    for (int y = 0; y < image.rows(); y++)
+        for (int x = 0; x < image.cols(); x++)
+            image[y][x] = (x + y) % 7 < 3 ? 255 : 0;
+
+    test_helper::expect_vectorized_operator_matches_scalar(test_helper::sobel, image);
+}
+
+TEST(simd, roberts_float_matches_scalar)
+{
+    test_helper::expect_vectorized_operator_matches_scalar<float>(test_helper::roberts, 0, 255);
+}
+
+TEST(simd, roberts_int_matches_scalar)
+{
+    test_helper::expect_vectorized_operator_matches_scalar<int>(test_helper::roberts, 0, 65535);
+}
+
+TEST(simd, roberts_uint8_matches_scalar)
+{
+    test_helper::expect_vectorized_operator_matches_scalar<std::uint8_t>(test_helper::roberts, 0, 255);
+}
+
+namespace test_helper
+{
+    constexpr auto fixed_point_blur = lib::make_kernel<3, 5, int>(
+        1, 2, 3, 2, 1,
+        2, 4, 6, 4, 2,
+        1, 2, 3, 2, 1);
+
+    constexpr auto fixed_point_edges = lib::make_kernel<3, 3, int>(
+        -3, 0, 3,
+        -10, 0, 10,
+        -3, 0, 3);
+}
+
+TEST(simd, fixed_point_convolve_matches_scalar)
+{
+    test_helper::simd_level_guard guard;
+    auto image = test_helper::random_image<std::uint8_t>(21, 67, 0, 255);
+
+    lib::simd::set_level(lib::simd_level::Scalar);
+    auto expected_blur = lib::convolve_fixed<test_helper::fixed_point_blur, 5>(image);
+    auto expected_edges = lib::convolve_fixed<test_helper::fixed_point_edges, 1, std::int16_t>(image);
+
+    for (auto level : test_helper::supported_vector_levels())
+    {
+        lib::simd::set_level(level);
+        test_helper::expect_equal(expected_blur, lib::convolve_fixed<test_helper::fixed_point_blur, 5>(image));
+        test_helper::expect_equal(expected_edges, lib::convolve_fixed<test_helper::fixed_point_edges, 1, std::int16_t>(image));
+    }
+}